@@ -0,0 +1,67 @@
+#ifndef clox_bytevec_h
+#define clox_bytevec_h
+
+#include "common.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// 바이트 단위 SIMD. numarray.c처럼 대상 아키텍처마다 같은 이름으로 맞춘다.
+// 마스크는 레인 i의 결과가 비트 i에 들어간다.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BYTE_LANES 32
+typedef __m256i ByteVec;
+#define BYTES_LOAD(p)       _mm256_loadu_si256((const __m256i*)(p))
+#define BYTES_HIGH_MASK(v)  ((uint32_t)_mm256_movemask_epi8(v))
+#define BYTES_SET1(c)       _mm256_set1_epi8((char)(c))
+#define BYTES_EQ_MASK(a, b) BYTES_HIGH_MASK(_mm256_cmpeq_epi8(a, b))
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BYTE_LANES 16
+typedef __m128i ByteVec;
+#define BYTES_LOAD(p)       _mm_loadu_si128((const __m128i*)(p))
+#define BYTES_HIGH_MASK(v)  ((uint32_t)_mm_movemask_epi8(v))
+#define BYTES_SET1(c)       _mm_set1_epi8((char)(c))
+#define BYTES_EQ_MASK(a, b) BYTES_HIGH_MASK(_mm_cmpeq_epi8(a, b))
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define BYTE_LANES 16
+typedef uint8x16_t ByteVec;
+#define BYTES_LOAD(p)       vld1q_u8((const uint8_t*)(p))
+#define BYTES_HIGH_MASK(v)  neonMask(vcltzq_s8(vreinterpretq_s8_u8(v)))
+#define BYTES_SET1(c)       vdupq_n_u8((uint8_t)(c))
+#define BYTES_EQ_MASK(a, b) neonMask(vceqq_u8(a, b))
+
+// NEON에는 movemask가 없어서 레인마다 자기 비트만 남기고 더한다.
+static inline uint32_t neonMask(uint8x16_t lanes) {
+    static const uint8_t bits[16] = {
+        1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128
+    };
+    uint8x16_t masked = vandq_u8(lanes, vld1q_u8(bits));
+    return (uint32_t)vaddv_u8(vget_low_u8(masked)) |
+           (uint32_t)vaddv_u8(vget_high_u8(masked)) << 8;
+}
+#else
+// SIMD가 없으면 한 바이트씩 돈다.
+#define BYTE_LANES 1
+typedef uint8_t ByteVec;
+#define BYTES_LOAD(p)       (*(const uint8_t*)(p))
+#define BYTES_HIGH_MASK(v)  ((uint32_t)((v) >> 7))
+#define BYTES_SET1(c)       ((uint8_t)(c))
+#define BYTES_EQ_MASK(a, b) ((uint32_t)((a) == (b)))
+#endif
+
+// 마스크에서 가장 낮은 켜진 비트의 레인 번호. mask는 0이 아니어야 한다.
+static inline int firstLane(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+#endif
@@ -9,6 +9,12 @@ typedef enum {
     OP_NIL,
     OP_TRUE,
     OP_FALSE,
+    OP_POP,
+    OP_GET_LOCAL,
+    OP_SET_LOCAL,
+    OP_GET_GLOBAL,
+    OP_DEFINE_GLOBAL,
+    OP_SET_GLOBAL,
     OP_EQUAL,
     OP_GREATER,
     OP_LESS,
@@ -18,20 +24,46 @@ typedef enum {
     OP_DIVIDE,
     OP_NOT,
     OP_NEGATE,
+    OP_PRINT,
+    OP_CALL_NATIVE,
     OP_RETURN,
 } OpCode;
 
+// 인라인 캐시가 모은 피연산자 타입
+typedef enum {
+    FEEDBACK_INT    = 1 << 0,
+    FEEDBACK_DOUBLE = 1 << 1,
+    FEEDBACK_STRING = 1 << 2,
+} TypeFeedback;
+
+// 명령어 하나에 딸린 실행 시간 정보. 컴파일러가 필요한 명령어에만 슬롯을
+// 잡고 명령어 뒤의 2바이트 피연산자로 슬롯 번호를 적는다. 지금은 산술과
+// 비교 명령어가 본 타입만 모은다.
+//
+// 캐시는 힌트일 뿐이어서 언제 비워도 실행 결과는 같다.
+typedef struct {
+    uint8_t types; // TypeFeedback 비트의 합
+} InlineCache;
+
 typedef struct {
     int count;
     int capacity;
     uint8_t* code;
     int* lines;
     ValueArray constants;
+    // 실행 중 스택에 동시에 올라가는 값의 최대 수. 컴파일러가 계산한다.
+    int maxStack;
+    int cacheCount;
+    int cacheCapacity;
+    InlineCache* caches;
 } Chunk;
 
 void initChunk(Chunk* chunk);
 void freeChunk(Chunk* chunk);
 void writeChunk(Chunk* chunk, uint8_t byte, int line);
 int addConstant(Chunk* chunk, Value value);
+int addCache(Chunk* chunk);
+// 모은 정보를 모두 버린다.
+void resetCaches(Chunk* chunk);
 
 #endif
\ No newline at end of file
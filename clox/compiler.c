@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "common.h"
 #include "compiler.h"
@@ -30,7 +31,7 @@ typedef enum {
     PREC_PRIMARY
 } Precedence;
 
-typedef void (*ParseFn)();
+typedef void (*ParseFn)(bool canAssign);
 
 typedef struct {
     ParseFn prefix;
@@ -38,7 +39,23 @@ typedef struct {
     Precedence precedence;
 } ParseRule;
 
+typedef struct {
+    Token name;
+    int depth; // -1이면 선언만 되고 초기화는 아직 안 됐다.
+} Local;
+
+// 지역 변수는 VM 스택의 고정 위치에 놓인다. locals의 인덱스가 곧 스택 슬롯이다.
+typedef struct {
+    Local locals[UINT8_COUNT];
+    int localCount;
+    int scopeDepth;
+    // 지금까지 내보낸 코드가 실행될 때의 스택 깊이와 그 최댓값
+    int stackDepth;
+    int maxStack;
+} Compiler;
+
 Parser parser;
+Compiler* current = NULL;
 Chunk* compilingChunk;
 
 static Chunk* currentChunk() {
@@ -85,6 +102,16 @@ static void advance() {
     }
 }
 
+static bool check(TokenType type) {
+    return parser.current.type == type;
+}
+
+static bool match(TokenType type) {
+    if (!check(type)) return false;
+    advance();
+    return true;
+}
+
 static void consume(TokenType type, const char* message) {
     if (parser.current.type == type) {
         advance();
@@ -104,8 +131,33 @@ static void emitBytes(uint8_t byte1, uint8_t byte2) {
     emitByte(byte2);
 }
 
+// 명령어마다 스택에 남기는 값의 수. OP_CALL_NATIVE는 인자도 꺼낸다.
+static const int stackEffects[] = {
+    [OP_CONSTANT] = 1, [OP_NIL] = 1, [OP_TRUE] = 1, [OP_FALSE] = 1,
+    [OP_POP] = -1,
+    [OP_GET_LOCAL] = 1, [OP_SET_LOCAL] = 0,
+    [OP_GET_GLOBAL] = 1, [OP_DEFINE_GLOBAL] = -1, [OP_SET_GLOBAL] = 0,
+    [OP_EQUAL] = -1, [OP_GREATER] = -1, [OP_LESS] = -1,
+    [OP_ADD] = -1, [OP_SUBTRACT] = -1, [OP_MULTIPLY] = -1, [OP_DIVIDE] = -1,
+    [OP_NOT] = 0, [OP_NEGATE] = 0,
+    [OP_PRINT] = -1, [OP_CALL_NATIVE] = 1, [OP_RETURN] = 0,
+};
+
+static void adjustStack(int effect) {
+    current->stackDepth += effect;
+    if (current->stackDepth > current->maxStack) {
+        current->maxStack = current->stackDepth;
+    }
+}
+
+// 명령어를 내보내고 스택 깊이를 따라간다. 피연산자는 emitByte로 붙인다.
+static void emitOp(OpCode op) {
+    emitByte(op);
+    adjustStack(stackEffects[op]);
+}
+
 static void emitReturn() {
-    emitByte(OP_RETURN);
+    emitOp(OP_RETURN);
 }
 
 static uint8_t makeConstant(Value value) {
@@ -119,11 +171,21 @@ static uint8_t makeConstant(Value value) {
 }
 
 static void emitConstant(Value value) {
-    emitBytes(OP_CONSTANT, makeConstant(value));
+    emitOp(OP_CONSTANT);
+    emitByte(makeConstant(value));
+}
+
+static void initCompiler(Compiler* compiler) {
+    compiler->localCount = 0;
+    compiler->scopeDepth = 0;
+    compiler->stackDepth = 0;
+    compiler->maxStack = 0;
+    current = compiler;
 }
 
 static void endCompiler() {
     emitReturn();
+    currentChunk()->maxStack = current->maxStack;
 #ifdef DEBUG_PRINT_CODE
     if (!parser.hadError) {
         disassembleChunk(currentChunk(), "code");
@@ -131,55 +193,200 @@ static void endCompiler() {
 #endif
 }
 
+// 인라인 캐시 슬롯을 하나 잡고 명령어 뒤에 슬롯 번호를 붙인다.
+static void emitCached(OpCode op) {
+    int cache = addCache(currentChunk());
+    if (cache > UINT16_MAX) {
+        error("Too many cached instructions in one chunk.");
+        return;
+    }
+    emitOp(op);
+    emitBytes((uint8_t)(cache >> 8), (uint8_t)(cache & 0xff));
+}
+
 static void expression();
+static void statement();
+static void declaration();
 static ParseRule* getRule(TokenType type);
 static void parsePrecedence(Precedence precedence);
 
-static void binary() {
+static void binary(bool canAssign) {
     TokenType operatorType = parser.previous.type;
     ParseRule* rule = getRule(operatorType);
     parsePrecedence((Precedence)(rule->precedence + 1));
 
     switch(operatorType) {
-        case TOKEN_BANG_EQUAL:    emitBytes(OP_EQUAL, OP_NOT); break;
-        case TOKEN_EQUAL_EQUAL:   emitByte(OP_EQUAL); break;
-        case TOKEN_GREATER:       emitByte(OP_GREATER); break;
-        case TOKEN_GREATER_EQUAL: emitBytes(OP_LESS, OP_NOT); break;
-        case TOKEN_LESS:          emitByte(OP_LESS); break;
-        case TOKEN_LESS_EQUAL:    emitBytes(OP_GREATER, OP_NOT); break;
-        case TOKEN_PLUS:          emitByte(OP_ADD); break;
-        case TOKEN_MINUS:         emitByte(OP_SUBTRACT); break;
-        case TOKEN_STAR:          emitByte(OP_MULTIPLY); break;
-        case TOKEN_SLASH:         emitByte(OP_DIVIDE); break;
+        case TOKEN_BANG_EQUAL:
+            emitOp(OP_EQUAL);
+            emitOp(OP_NOT);
+            break;
+        case TOKEN_EQUAL_EQUAL:   emitOp(OP_EQUAL); break;
+        case TOKEN_GREATER:       emitCached(OP_GREATER); break;
+        case TOKEN_GREATER_EQUAL:
+            emitCached(OP_LESS);
+            emitOp(OP_NOT);
+            break;
+        case TOKEN_LESS:          emitCached(OP_LESS); break;
+        case TOKEN_LESS_EQUAL:
+            emitCached(OP_GREATER);
+            emitOp(OP_NOT);
+            break;
+        case TOKEN_PLUS:          emitCached(OP_ADD); break;
+        case TOKEN_MINUS:         emitCached(OP_SUBTRACT); break;
+        case TOKEN_STAR:          emitCached(OP_MULTIPLY); break;
+        case TOKEN_SLASH:         emitCached(OP_DIVIDE); break;
         default: return; // 실행되지 않는 코드
     }
 }
 
-static void literal() {
+static void literal(bool canAssign) {
     switch (parser.previous.type) {
-        case TOKEN_FALSE: emitByte(OP_FALSE); break;
-        case TOKEN_NIL: emitByte(OP_NIL); break;
-        case TOKEN_TRUE: emitByte(OP_TRUE); break;
+        case TOKEN_FALSE: emitOp(OP_FALSE); break;
+        case TOKEN_NIL: emitOp(OP_NIL); break;
+        case TOKEN_TRUE: emitOp(OP_TRUE); break;
         default: return; // 실행되지 않는 코드
     }
 }
 
-static void grouping() {
+static void grouping(bool canAssign) {
     expression();
     consume(TOKEN_RIGHT_PAREN, "Expect ')' after expression.");
 }
 
-static void number() {
+static void number(bool canAssign) {
     double value = strtod(parser.previous.start, NULL);
+    // 정수 범위에 들어오는 리터럴은 정수 표현으로 둔다.
+    if (value >= INT32_MIN && value <= INT32_MAX &&
+        value == (int32_t)value) {
+        emitConstant(INT_VAL((int32_t)value));
+        return;
+    }
     emitConstant(NUMBER_VAL(value));
 }
 
-static void string() {
+static void string(bool canAssign) {
     emitConstant(OBJ_VAL(copyString(parser.previous.start + 1,
                                     parser.previous.length - 2)));
 }
 
-static void unary() {
+static uint8_t argumentList() {
+    uint8_t argCount = 0;
+    if (!check(TOKEN_RIGHT_PAREN)) {
+        do {
+            expression();
+            if (argCount == 255) {
+                error("Can't have more than 255 arguments.");
+            }
+            argCount++;
+        } while (match(TOKEN_COMMA));
+    }
+    consume(TOKEN_RIGHT_PAREN, "Expect ')' after arguments.");
+    return argCount;
+}
+
+// 네이티브는 컴파일 시점에 인덱스로 바꾼다. 없는 이름이면 -1
+static int resolveNative(Token* name) {
+    Value index;
+    ObjString* string = copyString(name->start, name->length);
+    if (!tableGet(&vm.nativeNames, string, &index)) return -1;
+    return (int)AS_NUMBER(index);
+}
+
+// 전역 이름을 VM의 전역 슬롯 인덱스로 바꾼다.
+static uint16_t globalSlot(Token* name) {
+    int slot = globalSlotFor(copyString(name->start, name->length));
+    if (slot > UINT16_MAX) {
+        error("Too many global variables.");
+        return 0;
+    }
+    return (uint16_t)slot;
+}
+
+static void emitGlobal(OpCode op, uint16_t slot) {
+    emitOp(op);
+    emitBytes((uint8_t)(slot >> 8), (uint8_t)(slot & 0xff));
+}
+
+static void nativeCall(int native) {
+    consume(TOKEN_LEFT_PAREN, "Expect '(' after native function name.");
+    uint8_t argCount = argumentList();
+
+    // 인자 개수는 여기서 검사하므로 런타임에는 검사하지 않는다.
+    int arity = vm.natives[native].arity;
+    if (arity != -1 && arity != argCount) {
+        char message[64];
+        snprintf(message, sizeof(message),
+                 "Expected %d arguments but got %d.", arity, argCount);
+        error(message);
+        return;
+    }
+
+    emitOp(OP_CALL_NATIVE);
+    emitBytes((uint8_t)native, argCount);
+    adjustStack(-argCount);
+}
+
+static bool identifiersEqual(Token* a, Token* b) {
+    if (a->length != b->length) return false;
+    return memcmp(a->start, b->start, a->length) == 0;
+}
+
+// 지역 변수의 스택 슬롯을 찾는다. 지역 변수가 아니면 -1
+static int resolveLocal(Compiler* compiler, Token* name) {
+    // 안쪽 스코프부터 찾아야 섀도잉이 맞게 된다.
+    for (int i = compiler->localCount - 1; i >= 0; i--) {
+        Local* local = &compiler->locals[i];
+        if (identifiersEqual(name, &local->name)) {
+            if (local->depth == -1) {
+                error("Can't read local variable in its own initializer.");
+            }
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void namedVariable(Token name, bool canAssign) {
+    int arg = resolveLocal(current, &name);
+    if (arg != -1) {
+        if (canAssign && match(TOKEN_EQUAL)) {
+            expression();
+            emitOp(OP_SET_LOCAL);
+            emitByte((uint8_t)arg);
+        } else {
+            emitOp(OP_GET_LOCAL);
+            emitByte((uint8_t)arg);
+        }
+        return;
+    }
+
+    uint16_t slot = globalSlot(&name);
+
+    if (canAssign && match(TOKEN_EQUAL)) {
+        expression();
+        emitGlobal(OP_SET_GLOBAL, slot);
+    } else {
+        emitGlobal(OP_GET_GLOBAL, slot);
+    }
+}
+
+static void variable(bool canAssign) {
+    // 이름 뒤에 괄호가 오면 네이티브 호출이다.
+    if (check(TOKEN_LEFT_PAREN)) {
+        int native = resolveNative(&parser.previous);
+        if (native == -1) {
+            error("Undefined native function.");
+            return;
+        }
+        nativeCall(native);
+        return;
+    }
+
+    namedVariable(parser.previous, canAssign);
+}
+
+static void unary(bool canAssign) {
     TokenType operatorType = parser.previous.type;
 
     // 피연산자를 컴파일한다.
@@ -187,8 +394,8 @@ static void unary() {
 
     // 연산자의 옵코드를 vm에 저장한다.
     switch (operatorType) {
-        case TOKEN_BANG: emitByte(OP_NOT); break;
-        case TOKEN_MINUS: emitByte(OP_NEGATE); break;
+        case TOKEN_BANG: emitOp(OP_NOT); break;
+        case TOKEN_MINUS: emitOp(OP_NEGATE); break;
         default: return; // 실행되지 않는 코드.
     }
 }
@@ -213,7 +420,7 @@ ParseRule rules[] = {
     [TOKEN_GREATER_EQUAL]   = {NULL , binary, PREC_COMPARISON},
     [TOKEN_LESS]            = {NULL , binary, PREC_COMPARISON},
     [TOKEN_LESS_EQUAL]      = {NULL , binary, PREC_COMPARISON},
-    [TOKEN_IDENTIFIER]      = {NULL , NULL, PREC_NONE},
+    [TOKEN_IDENTIFIER]      = {variable , NULL, PREC_NONE},
     [TOKEN_STRING]          = {string , NULL, PREC_NONE},
     [TOKEN_NUMBER]          = {number , NULL, PREC_NONE},
     [TOKEN_AND]             = {NULL , NULL, PREC_NONE},
@@ -244,7 +451,8 @@ static void parsePrecedence(Precedence precedence) {
         return;
     }
 
-    prefixRule();
+    bool canAssign = precedence <= PREC_ASSIGNMENT;
+    prefixRule(canAssign);
 
     /* precedence 는 이항 연산자의 우선순위임.
        즉, while문은 parser.current가 이항 연산자일 때만 실행됨.
@@ -257,7 +465,11 @@ static void parsePrecedence(Precedence precedence) {
     while (precedence <= getRule(parser.current.type)->precedence) {
         advance();
         ParseFn infixRule = getRule(parser.previous.type)->infix;
-        infixRule();
+        infixRule(canAssign);
+    }
+
+    if (canAssign && match(TOKEN_EQUAL)) {
+        error("Invalid assignment target.");
     }
 }
 
@@ -270,15 +482,168 @@ static void expression() {
     parsePrecedence(PREC_ASSIGNMENT);
 }
 
+static void beginScope() {
+    current->scopeDepth++;
+}
+
+static void endScope() {
+    current->scopeDepth--;
+
+    // 스코프를 벗어난 지역 변수를 스택에서 버린다.
+    while (current->localCount > 0 &&
+           current->locals[current->localCount - 1].depth >
+               current->scopeDepth) {
+        emitOp(OP_POP);
+        current->localCount--;
+    }
+}
+
+static void addLocal(Token name) {
+    if (current->localCount == UINT8_COUNT) {
+        error("Too many local variables in function.");
+        return;
+    }
+
+    Local* local = &current->locals[current->localCount++];
+    local->name = name;
+    local->depth = -1;
+}
+
+static void declareVariable() {
+    if (current->scopeDepth == 0) return;
+
+    Token* name = &parser.previous;
+    for (int i = current->localCount - 1; i >= 0; i--) {
+        Local* local = &current->locals[i];
+        if (local->depth != -1 && local->depth < current->scopeDepth) {
+            break;
+        }
+
+        if (identifiersEqual(name, &local->name)) {
+            error("Already a variable with this name in this scope.");
+        }
+    }
+
+    addLocal(*name);
+}
+
+// 전역이면 슬롯 인덱스를 돌려주고, 지역이면 스택에 자리만 잡고 0을 돌려준다.
+static uint16_t parseVariable(const char* errorMessage) {
+    consume(TOKEN_IDENTIFIER, errorMessage);
+
+    declareVariable();
+    if (current->scopeDepth > 0) return 0;
+
+    return globalSlot(&parser.previous);
+}
+
+static void markInitialized() {
+    current->locals[current->localCount - 1].depth = current->scopeDepth;
+}
+
+static void defineVariable(uint16_t global) {
+    // 지역 변수는 초기값이 이미 자기 스택 슬롯에 있으므로 명령어가 필요 없다.
+    if (current->scopeDepth > 0) {
+        markInitialized();
+        return;
+    }
+
+    emitGlobal(OP_DEFINE_GLOBAL, global);
+}
+
+static void block() {
+    while (!check(TOKEN_RIGHT_BRACE) && !check(TOKEN_EOF)) {
+        declaration();
+    }
+
+    consume(TOKEN_RIGHT_BRACE, "Expect '}' after block.");
+}
+
+static void varDeclaration() {
+    uint16_t global = parseVariable("Expect variable name.");
+
+    if (match(TOKEN_EQUAL)) {
+        expression();
+    } else {
+        emitOp(OP_NIL);
+    }
+    consume(TOKEN_SEMICOLON, "Expect ';' after variable declaration.");
+
+    defineVariable(global);
+}
+
+static void expressionStatement() {
+    expression();
+    consume(TOKEN_SEMICOLON, "Expect ';' after expression.");
+    emitOp(OP_POP);
+}
+
+static void printStatement() {
+    expression();
+    consume(TOKEN_SEMICOLON, "Expect ';' after value.");
+    emitOp(OP_PRINT);
+}
+
+// 패닉 모드에서 다음 문장 경계까지 토큰을 버린다.
+static void synchronize() {
+    parser.panicMode = false;
+
+    while (parser.current.type != TOKEN_EOF) {
+        if (parser.previous.type == TOKEN_SEMICOLON) return;
+        switch (parser.current.type) {
+            case TOKEN_CLASS:
+            case TOKEN_FUN:
+            case TOKEN_VAR:
+            case TOKEN_FOR:
+            case TOKEN_IF:
+            case TOKEN_WHILE:
+            case TOKEN_PRINT:
+            case TOKEN_RETURN:
+                return;
+            default:
+                ; // 아무것도 하지 않는다.
+        }
+
+        advance();
+    }
+}
+
+static void declaration() {
+    if (match(TOKEN_VAR)) {
+        varDeclaration();
+    } else {
+        statement();
+    }
+
+    if (parser.panicMode) synchronize();
+}
+
+static void statement() {
+    if (match(TOKEN_PRINT)) {
+        printStatement();
+    } else if (match(TOKEN_LEFT_BRACE)) {
+        beginScope();
+        block();
+        endScope();
+    } else {
+        expressionStatement();
+    }
+}
+
 bool compile(const char* source, Chunk* chunk) {
     initScanner(source);
+    Compiler compiler;
+    initCompiler(&compiler);
     compilingChunk = chunk;
 
     parser.hadError = false;
     parser.panicMode = false;
     advance();
-    expression();
-    consume(TOKEN_EOF, "Expect end of expression.");
+
+    while (!match(TOKEN_EOF)) {
+        declaration();
+    }
+
     endCompiler();
     return !parser.hadError;
 }
\ No newline at end of file
@@ -2,7 +2,9 @@
 
 #include "chunk.h"
 #include "debug.h"
+#include "object.h"
 #include "value.h"
+#include "vm.h"
 
 void disassembleChunk(Chunk* chunk, const char* name) {
     printf("== %s ==\n", name);
@@ -21,6 +23,48 @@ static int constantInstruction(const char* name, Chunk* chunk,
     return offset + 2;
     }
 
+static int nativeInstruction(const char* name, Chunk* chunk,
+                             int offset) {
+    uint8_t native = chunk->code[offset + 1];
+    uint8_t argCount = chunk->code[offset + 2];
+    printf("%-16s %4d '%s' (%d args)\n", name, native,
+           vm.natives[native].name->chars, argCount);
+    return offset + 3;
+}
+
+static int globalInstruction(const char* name, Chunk* chunk,
+                             int offset) {
+    uint16_t slot = (uint16_t)(chunk->code[offset + 1] << 8);
+    slot |= chunk->code[offset + 2];
+    printf("%-16s %4d '", name, slot);
+    printValue(vm.globalIdentifiers.values[slot]);
+    printf("'\n");
+    return offset + 3;
+}
+
+static int byteInstruction(const char* name, Chunk* chunk,
+                           int offset) {
+    uint8_t slot = chunk->code[offset + 1];
+    printf("%-16s %4d\n", name, slot);
+    return offset + 2;
+}
+
+static int cacheInstruction(const char* name, Chunk* chunk,
+                            int offset) {
+    uint16_t cache = (uint16_t)(chunk->code[offset + 1] << 8);
+    cache |= chunk->code[offset + 2];
+    printf("%-16s %4d", name, cache);
+    // 얼린 프로그램의 청크는 실행할 때만 캐시를 가진다.
+    if (chunk->caches != NULL) {
+        uint8_t types = chunk->caches[cache].types;
+        if (types & FEEDBACK_INT) printf(" int");
+        if (types & FEEDBACK_DOUBLE) printf(" double");
+        if (types & FEEDBACK_STRING) printf(" string");
+    }
+    printf("\n");
+    return offset + 3;
+}
+
 static int simpleInstruction(const char* name, int offset) {
     printf("%s\n", name);
     return offset + 1;
@@ -45,24 +89,40 @@ int disassembleInstruction(Chunk* chunk, int offset) {
             return simpleInstruction("OP_TRUE", offset);
         case OP_FALSE:
             return simpleInstruction("OP_FALSE", offset);
+        case OP_POP:
+            return simpleInstruction("OP_POP", offset);
+        case OP_GET_LOCAL:
+            return byteInstruction("OP_GET_LOCAL", chunk, offset);
+        case OP_SET_LOCAL:
+            return byteInstruction("OP_SET_LOCAL", chunk, offset);
+        case OP_GET_GLOBAL:
+            return globalInstruction("OP_GET_GLOBAL", chunk, offset);
+        case OP_DEFINE_GLOBAL:
+            return globalInstruction("OP_DEFINE_GLOBAL", chunk, offset);
+        case OP_SET_GLOBAL:
+            return globalInstruction("OP_SET_GLOBAL", chunk, offset);
         case OP_EQUAL:
             return simpleInstruction("OP_EQUAL", offset);
         case OP_GREATER:
-            return simpleInstruction("OP_GREATER", offset);
+            return cacheInstruction("OP_GREATER", chunk, offset);
         case OP_LESS:
-            return simpleInstruction("OP_LESS", offset);
+            return cacheInstruction("OP_LESS", chunk, offset);
         case OP_ADD:
-            return simpleInstruction("OP_ADD", offset);
+            return cacheInstruction("OP_ADD", chunk, offset);
         case OP_SUBTRACT:
-            return simpleInstruction("OP_SUBTRACT", offset);
+            return cacheInstruction("OP_SUBTRACT", chunk, offset);
         case OP_MULTIPLY:
-            return simpleInstruction("OP_MULTIPLY", offset);
+            return cacheInstruction("OP_MULTIPLY", chunk, offset);
         case OP_DIVIDE:
-            return simpleInstruction("OP_DIVIDE", offset);
+            return cacheInstruction("OP_DIVIDE", chunk, offset);
         case OP_NOT:
             return simpleInstruction("OP_NOT", offset);
         case OP_NEGATE:
             return simpleInstruction("OP_NEGATE", offset);
+        case OP_PRINT:
+            return simpleInstruction("OP_PRINT", offset);
+        case OP_CALL_NATIVE:
+            return nativeInstruction("OP_CALL_NATIVE", chunk, offset);
         case OP_RETURN:
             return simpleInstruction("OP_RETURN", offset);
         default:
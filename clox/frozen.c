@@ -0,0 +1,150 @@
+// MAP_ANONYMOUS는 POSIX 확장이다.
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "compiler.h"
+#include "frozen.h"
+#include "memory.h"
+#include "object.h"
+
+// 매핑 안의 모든 블록을 8바이트 경계에 맞춘다.
+#define ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+static size_t frozenValueSize(Value value) {
+    if (!IS_STRING(value)) return 0;
+    return ALIGN(sizeof(ObjExternalString) + AS_STRING(value)->length + 1);
+}
+
+// 값을 매핑 안으로 옮긴다. 문자열이면 *cursor 위치에 복사본을 만든다.
+static Value freezeValue(Value value, uint8_t** cursor) {
+    if (!IS_STRING(value)) return value;
+
+    ObjString* string = AS_STRING(value);
+    ObjExternalString* frozen = (ObjExternalString*)*cursor;
+    char* chars = (char*)(frozen + 1);
+    memcpy(chars, string->chars, string->length);
+    chars[string->length] = '\0';
+
+    frozen->string.obj.type = OBJ_STRING;
+    frozen->string.obj.isScratch = false;
+    frozen->string.obj.isImage = false;
+    frozen->string.obj.isShared = false;
+    frozen->string.obj.isFrozen = true;
+    frozen->string.obj.next = NULL;
+    frozen->string.length = string->length;
+    frozen->string.chars = chars;
+    // 매핑은 읽기 전용이 되므로 해시를 나중에 채울 수 없다.
+    frozen->string.hash = stringHash(string);
+    frozen->string.hashed = true;
+    frozen->string.encoding = stringEncoding(string);
+    frozen->string.kind = STRING_EXTERNAL;
+    frozen->release = NULL;
+    frozen->context = NULL;
+
+    *cursor += frozenValueSize(value);
+    return OBJ_VAL(&frozen->string);
+}
+
+FrozenProgram* compileFrozen(const char* source) {
+    Chunk chunk;
+    initChunk(&chunk);
+    if (!compile(source, &chunk)) {
+        freeChunk(&chunk);
+        return NULL;
+    }
+
+    int globalCount = vm.globalIdentifiers.count;
+    size_t size = ALIGN(sizeof(FrozenProgram));
+    size_t code = size;
+    size += ALIGN(sizeof(uint8_t) * chunk.count);
+    size_t lines = size;
+    size += ALIGN(sizeof(int) * chunk.count);
+    size_t constants = size;
+    size += sizeof(Value) * chunk.constants.count;
+    size_t globalNames = size;
+    size += sizeof(Value) * globalCount;
+    size_t strings = size;
+    for (int i = 0; i < chunk.constants.count; i++) {
+        size += frozenValueSize(chunk.constants.values[i]);
+    }
+    for (int i = 0; i < globalCount; i++) {
+        size += frozenValueSize(vm.globalIdentifiers.values[i]);
+    }
+
+    uint8_t* base = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        freeChunk(&chunk);
+        return NULL;
+    }
+
+    FrozenProgram* program = (FrozenProgram*)base;
+    program->size = size;
+    program->chunk.count = chunk.count;
+    program->chunk.capacity = chunk.count;
+    program->chunk.code = base + code;
+    program->chunk.lines = (int*)(base + lines);
+    program->chunk.maxStack = chunk.maxStack;
+    // 캐시는 실행마다 새로 잡으므로 매핑에는 슬롯 수만 남긴다.
+    program->chunk.cacheCount = chunk.cacheCount;
+    program->chunk.cacheCapacity = 0;
+    program->chunk.caches = NULL;
+    memcpy(program->chunk.code, chunk.code, sizeof(uint8_t) * chunk.count);
+    memcpy(program->chunk.lines, chunk.lines, sizeof(int) * chunk.count);
+
+    uint8_t* cursor = base + strings;
+    program->chunk.constants.count = chunk.constants.count;
+    program->chunk.constants.capacity = chunk.constants.count;
+    program->chunk.constants.values = (Value*)(base + constants);
+    for (int i = 0; i < chunk.constants.count; i++) {
+        program->chunk.constants.values[i] =
+            freezeValue(chunk.constants.values[i], &cursor);
+    }
+
+    program->globalCount = globalCount;
+    program->globalNames = (Value*)(base + globalNames);
+    for (int i = 0; i < globalCount; i++) {
+        program->globalNames[i] =
+            freezeValue(vm.globalIdentifiers.values[i], &cursor);
+    }
+
+    freeChunk(&chunk);
+    // 이후로는 아무도 이 메모리에 쓸 수 없다.
+    mprotect(base, size, PROT_READ);
+    return program;
+}
+
+// 바이트코드의 전역 슬롯 번호는 컴파일한 VM 기준이다. 같은 이름이 같은
+// 슬롯에 오도록 처음 보는 이름은 순서대로 만들고, 어긋나면 실행하지 않는다.
+static bool bindGlobals(FrozenProgram* program) {
+    for (int i = 0; i < program->globalCount; i++) {
+        ObjString* name = internString(AS_STRING(program->globalNames[i]));
+        if (globalSlotFor(name) != i) {
+            fprintf(stderr, "Global '%s' does not match the slot it was "
+                    "compiled for.\n", name->chars);
+            return false;
+        }
+    }
+    return true;
+}
+
+// 매핑은 읽기 전용이고 여러 VM이 함께 실행하므로, 인라인 캐시는 실행마다
+// 따로 잡은 청크 사본에 둔다.
+InterpretResult runFrozen(FrozenProgram* program) {
+    if (!bindGlobals(program)) return INTERPRET_COMPILE_ERROR;
+
+    Chunk chunk = program->chunk;
+    chunk.cacheCapacity = chunk.cacheCount;
+    chunk.caches = ALLOCATE(InlineCache, chunk.cacheCapacity);
+    resetCaches(&chunk);
+    InterpretResult result = interpretChunk(&chunk);
+    FREE_ARRAY(InlineCache, chunk.caches, chunk.cacheCapacity);
+    return result;
+}
+
+void freeFrozen(FrozenProgram* program) {
+    munmap(program, program->size);
+}
@@ -0,0 +1,26 @@
+#ifndef clox_frozen_h
+#define clox_frozen_h
+
+#include "chunk.h"
+#include "vm.h"
+
+// 한 번 컴파일해서 얼려 둔 프로그램. 바이트코드, 줄 번호, 상수, 문자열
+// 상수까지 하나의 읽기 전용 매핑에 들어 있다. VM은 이 메모리를 읽기만 하고
+// 해제하지 않으므로 여러 VM이 동기화 없이 함께 실행할 수 있다.
+//
+// 문자열 상수는 해제 콜백 없는 외부 문자열로 들어가서 VM의 인터닝 테이블과
+// 얽히지 않는다. 비교는 내용으로 하고 해시는 미리 계산해 둔다.
+typedef struct {
+    Chunk chunk;
+    // 컴파일할 때 정해진 전역 슬롯 순서. 실행할 때 VM의 슬롯과 맞춰 본다.
+    int globalCount;
+    Value* globalNames;
+    size_t size;
+} FrozenProgram;
+
+FrozenProgram* compileFrozen(const char* source);
+InterpretResult runFrozen(FrozenProgram* program);
+// 프로그램의 문자열을 참조하는 VM이 모두 사라진 뒤에 해제한다.
+void freeFrozen(FrozenProgram* program);
+
+#endif
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "hash.h"
+
+static uint64_t seed[2];
+static bool seeded = false;
+
+void initHashSeed() {
+    if (seeded) return;
+
+    FILE* random = fopen("/dev/urandom", "rb");
+    if (random == NULL || fread(seed, sizeof(seed), 1, random) != 1) {
+        // 난수 장치가 없으면 시각과 주소로 대신한다.
+        seed[0] = (uint64_t)time(NULL) ^ (uint64_t)clock() << 32;
+        seed[1] = (uint64_t)(uintptr_t)&seed ^ 0x9e3779b97f4a7c15u;
+    }
+    if (random != NULL) fclose(random);
+    seeded = true;
+}
+
+#define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+// 64비트 값을 고르게 섞는다(MurmurHash3의 마무리 함수).
+static inline uint64_t mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdu;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53u;
+    x ^= x >> 33;
+    return x;
+}
+
+// 16바이트 이하의 키. 대부분의 식별자와 맵 키가 여기에 해당한다.
+// 두 워드에 시드를 섞어 곱셈 혼합 한 번으로 끝낸다.
+static uint32_t hashShort(const char* key, int length) {
+    uint64_t a = 0;
+    uint64_t b = 0;
+    memcpy(&a, key, length < 8 ? length : 8);
+    if (length > 8) memcpy(&b, key + 8, length - 8);
+
+    uint64_t hash = mix((a ^ seed[0]) * 0x9e3779b97f4a7c15u +
+                        ROTL(b ^ seed[1], 29) + (uint64_t)length);
+    return (uint32_t)(hash ^ hash >> 32);
+}
+
+#define SIP_ROUND() \
+    do { \
+        v0 += v1; v1 = ROTL(v1, 13); v1 ^= v0; v0 = ROTL(v0, 32); \
+        v2 += v3; v3 = ROTL(v3, 16); v3 ^= v2; \
+        v0 += v3; v3 = ROTL(v3, 21); v3 ^= v0; \
+        v2 += v1; v1 = ROTL(v1, 17); v1 ^= v2; v2 = ROTL(v2, 32); \
+    } while (false)
+
+// 긴 키는 SipHash-1-3
+static uint32_t hashLong(const char* key, int length) {
+    uint64_t v0 = seed[0] ^ 0x736f6d6570736575u;
+    uint64_t v1 = seed[1] ^ 0x646f72616e646f6du;
+    uint64_t v2 = seed[0] ^ 0x6c7967656e657261u;
+    uint64_t v3 = seed[1] ^ 0x7465646279746573u;
+
+    const char* end = key + (length & ~7);
+    for (const char* p = key; p < end; p += 8) {
+        uint64_t m;
+        memcpy(&m, p, 8);
+        v3 ^= m;
+        SIP_ROUND();
+        v0 ^= m;
+    }
+
+    uint64_t last = (uint64_t)length << 56;
+    for (int i = 0; i < (length & 7); i++) {
+        last |= (uint64_t)(uint8_t)end[i] << (8 * i);
+    }
+    v3 ^= last;
+    SIP_ROUND();
+    v0 ^= last;
+
+    v2 ^= 0xff;
+    SIP_ROUND();
+    SIP_ROUND();
+    SIP_ROUND();
+    uint64_t hash = v0 ^ v1 ^ v2 ^ v3;
+    return (uint32_t)(hash ^ hash >> 32);
+}
+
+uint32_t hashString(const char* key, int length) {
+    if (length <= 16) return hashShort(key, length);
+    return hashLong(key, length);
+}
@@ -0,0 +1,14 @@
+#ifndef clox_hash_h
+#define clox_hash_h
+
+#include "common.h"
+
+// 문자열 해시. 프로세스마다 임의의 시드를 쓰므로 밖에서 충돌하는 키를
+// 미리 만들어 테이블 탐색을 길게 늘어뜨릴 수 없다. 해시 값은 같은 프로세스
+// 안에서만 의미가 있다.
+
+// 첫 해시보다 먼저 부른다. 여러 번 불러도 된다.
+void initHashSeed();
+uint32_t hashString(const char* key, int length);
+
+#endif
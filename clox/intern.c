@@ -0,0 +1,167 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "hash.h"
+#include "intern.h"
+#include "memory.h"
+
+#define SHARD_COUNT 64
+#define SHARD_INITIAL_CAPACITY 64
+#define SHARD_MAX_LOAD 0.5
+
+// 샤드의 슬롯 배열. 문자열을 지우지 않으므로 툼스톤이 없고, 슬롯은
+// NULL에서 문자열로 한 번만 바뀐다. 그래서 읽는 쪽은 락 없이 탐색할 수 있다.
+typedef struct SlotArray {
+    struct SlotArray* retired;
+    int capacity;
+    _Atomic(ObjString*) slots[];
+} SlotArray;
+
+typedef struct {
+    pthread_mutex_t lock;
+    _Atomic(SlotArray*) array;
+    int count;
+} Shard;
+
+static bool enabled = false;
+static Shard shards[SHARD_COUNT];
+
+static SlotArray* newSlotArray(int capacity) {
+    SlotArray* array = (SlotArray*)reallocate(NULL, 0,
+        sizeof(SlotArray) + sizeof(ObjString*) * capacity);
+    array->retired = NULL;
+    array->capacity = capacity;
+    for (int i = 0; i < capacity; i++) {
+        atomic_init(&array->slots[i], NULL);
+    }
+    return array;
+}
+
+void enableSharedStrings() {
+    if (enabled) return;
+    // 스레드가 생기기 전에 시드를 정해 둔다.
+    initHashSeed();
+    for (int i = 0; i < SHARD_COUNT; i++) {
+        pthread_mutex_init(&shards[i].lock, NULL);
+        atomic_init(&shards[i].array, newSlotArray(SHARD_INITIAL_CAPACITY));
+        shards[i].count = 0;
+    }
+    enabled = true;
+}
+
+bool sharedStringsEnabled() {
+    return enabled;
+}
+
+// 샤드는 해시의 위쪽 비트로, 슬롯은 아래쪽 비트로 고른다.
+static Shard* shardFor(uint32_t hash) {
+    return &shards[hash >> 26];
+}
+
+static ObjString* findInArray(SlotArray* array, const char* chars,
+                              int length, uint32_t hash) {
+    uint32_t mask = (uint32_t)array->capacity - 1;
+    for (uint32_t index = hash & mask;; index = (index + 1) & mask) {
+        ObjString* string = atomic_load_explicit(&array->slots[index],
+                                                 memory_order_acquire);
+        if (string == NULL) return NULL;
+        if (string->hash == hash && string->length == length &&
+            memcmp(string->chars, chars, length) == 0) {
+            return string;
+        }
+    }
+}
+
+ObjString* findSharedString(const char* chars, int length, uint32_t hash) {
+    SlotArray* array = atomic_load_explicit(&shardFor(hash)->array,
+                                            memory_order_acquire);
+    return findInArray(array, chars, length, hash);
+}
+
+static void insertSlot(SlotArray* array, ObjString* string) {
+    uint32_t mask = (uint32_t)array->capacity - 1;
+    uint32_t index = string->hash & mask;
+    while (atomic_load_explicit(&array->slots[index],
+                                memory_order_relaxed) != NULL) {
+        index = (index + 1) & mask;
+    }
+    atomic_store_explicit(&array->slots[index], string,
+                          memory_order_release);
+}
+
+// 새 배열을 채운 뒤에 공개한다. 옛 배열을 읽는 스레드가 있을 수 있으므로
+// 옛 배열은 해제하지 않고 새 배열에 매달아 둔다.
+static void growShard(Shard* shard, SlotArray* array) {
+    SlotArray* grown = newSlotArray(array->capacity * 2);
+    for (int i = 0; i < array->capacity; i++) {
+        ObjString* string = atomic_load_explicit(&array->slots[i],
+                                                 memory_order_relaxed);
+        if (string != NULL) insertSlot(grown, string);
+    }
+    grown->retired = array;
+    atomic_store_explicit(&shard->array, grown, memory_order_release);
+}
+
+ObjString* internSharedString(char* chars, int length, uint32_t hash) {
+    Shard* shard = shardFor(hash);
+    pthread_mutex_lock(&shard->lock);
+
+    // 락을 잡기 전에 다른 스레드가 같은 문자열을 넣었을 수 있다.
+    SlotArray* array = atomic_load_explicit(&shard->array,
+                                            memory_order_relaxed);
+    ObjString* string = findInArray(array, chars, length, hash);
+    if (string != NULL) {
+        pthread_mutex_unlock(&shard->lock);
+        FREE_ARRAY(char, chars, length + 1);
+        return string;
+    }
+
+    string = ALLOCATE(ObjString, 1);
+    string->obj.type = OBJ_STRING;
+    string->obj.isScratch = false;
+    string->obj.isImage = false;
+    string->obj.isShared = true;
+    string->obj.isFrozen = false;
+    string->obj.next = NULL;
+    string->length = length;
+    string->chars = chars;
+    string->hash = hash;
+    string->kind = STRING_INTERNED;
+    string->hashed = true;
+    // 여러 스레드가 읽으므로 나중에 채우지 않고 공개하기 전에 검사한다.
+    string->encoding = detectEncoding(chars, length);
+
+    if (shard->count + 1 > array->capacity * SHARD_MAX_LOAD) {
+        growShard(shard, array);
+        array = atomic_load_explicit(&shard->array, memory_order_relaxed);
+    }
+    insertSlot(array, string);
+    shard->count++;
+
+    pthread_mutex_unlock(&shard->lock);
+    return string;
+}
+
+void freeSharedStrings() {
+    if (!enabled) return;
+    for (int i = 0; i < SHARD_COUNT; i++) {
+        Shard* shard = &shards[i];
+        SlotArray* array = atomic_load(&shard->array);
+        for (int j = 0; j < array->capacity; j++) {
+            ObjString* string = atomic_load(&array->slots[j]);
+            if (string == NULL) continue;
+            FREE_ARRAY(char, string->chars, string->length + 1);
+            FREE(ObjString, string);
+        }
+
+        while (array != NULL) {
+            SlotArray* retired = array->retired;
+            reallocate(array, sizeof(SlotArray) +
+                       sizeof(ObjString*) * array->capacity, 0);
+            array = retired;
+        }
+        pthread_mutex_destroy(&shard->lock);
+    }
+    enabled = false;
+}
@@ -0,0 +1,23 @@
+#ifndef clox_intern_h
+#define clox_intern_h
+
+#include "common.h"
+#include "object.h"
+
+// 프로세스 전체가 공유하는 문자열 인터닝 테이블. 켜 두면 copyString()과
+// takeString()이 vm.strings 대신 이 테이블을 써서 여러 스레드의 VM이 같은
+// 문자열 객체를 공유한다. 같은 내용이면 어느 VM에서 만들어도 같은 포인터다.
+//
+// 조회는 락 없이 하고, 삽입은 해시로 고른 샤드 하나만 잠근다.
+// 공유 문자열은 어느 VM에도 속하지 않고 freeSharedStrings()에서만 해제된다.
+
+// 첫 initVM()보다, 그리고 스레드를 띄우기보다 먼저 불러야 한다.
+void enableSharedStrings();
+bool sharedStringsEnabled();
+ObjString* findSharedString(const char* chars, int length, uint32_t hash);
+// chars는 힙 버퍼이고 소유권을 가져간다. 이미 있으면 chars를 해제한다.
+ObjString* internSharedString(char* chars, int length, uint32_t hash);
+// 모든 VM을 해제한 뒤에 부른다.
+void freeSharedStrings();
+
+#endif
@@ -9,6 +9,8 @@
 
 static void repl() {
     char line[1024];
+    // 줄마다 생긴 임시 문자열은 그 줄이 끝나면 한꺼번에 버린다.
+    vm.scratchMode = true;
     for (;;) {
         printf("> ");
         
@@ -14,14 +14,66 @@ void* reallocate(void* pointer, size_t oldSize, size_t newSize) {
     return result;
 }
 
+// 이미지 객체는 loadSnapshot()이 힙으로 옮긴 버퍼만 해제한다.
+static void freeImageObject(Obj* object) {
+    switch (object->type) {
+        case OBJ_MAP:
+            freeOrderedTable(&((ObjMap*)object)->table);
+            break;
+        case OBJ_STRING_BUILDER: {
+            ObjStringBuilder* builder = (ObjStringBuilder*)object;
+            FREE_ARRAY(char, builder->chars, builder->capacity);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
 static void freeObject(Obj* object) {
+    if (object->isImage) {
+        freeImageObject(object);
+        return;
+    }
+
     switch (object->type) {
+        case OBJ_MAP: {
+            ObjMap* map = (ObjMap*)object;
+            freeOrderedTable(&map->table);
+            FREE(ObjMap, object);
+            break;
+        }
+        case OBJ_NUMBER_ARRAY: {
+            ObjNumberArray* array = (ObjNumberArray*)object;
+            FREE_ARRAY(double, array->values, array->count);
+            FREE(ObjNumberArray, object);
+            break;
+        }
         case OBJ_STRING: {
             ObjString* string = (ObjString*)object;
+            if (string->kind == STRING_SLICE) {
+                FREE(ObjStringSlice, object);
+                break;
+            }
+            if (string->kind == STRING_EXTERNAL) {
+                ObjExternalString* external = (ObjExternalString*)object;
+                if (external->release != NULL) {
+                    external->release(external->context, string->chars,
+                                      string->length);
+                }
+                FREE(ObjExternalString, object);
+                break;
+            }
             FREE_ARRAY(char, string->chars, string->length + 1);
             FREE(ObjString, object);
             break;
         }
+        case OBJ_STRING_BUILDER: {
+            ObjStringBuilder* builder = (ObjStringBuilder*)object;
+            FREE_ARRAY(char, builder->chars, builder->capacity);
+            FREE(ObjStringBuilder, object);
+            break;
+        }
     }
 }
 
@@ -0,0 +1,465 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "common.h"
+#include "natives.h"
+#include "numarray.h"
+#include "object.h"
+#include "strsearch.h"
+#include "vm.h"
+
+static Value clockNative(int argCount, Value* args) {
+    return NUMBER_VAL((double)clock() / CLOCKS_PER_SEC);
+}
+
+// map()과 stringBuilder()가 받는 예상 크기의 상한
+#define CAPACITY_HINT_MAX (1 << 24)
+
+// 정수이고 [0, max] 범위인지 검사한다. NaN과 범위 밖의 값은 int로
+// 바꾸기 전에 걸러진다.
+static bool checkPosition(Value position, int max) {
+    if (!IS_NUMBER(position)) return false;
+    double number = AS_NUMBER(position);
+    return number >= 0 && number <= max && number == (int)number;
+}
+
+// 숫자 배열
+
+static Value numberArrayNative(int argCount, Value* args) {
+    if (!checkPosition(args[0], NUMBER_ARRAY_MAX)) {
+        return nativeError("Array size must be an integer between 0 and %d.",
+                           NUMBER_ARRAY_MAX);
+    }
+    return OBJ_VAL(newNumberArray((int)AS_NUMBER(args[0])));
+}
+
+static Value arrayLengthNative(int argCount, Value* args) {
+    if (!IS_NUMBER_ARRAY(args[0])) {
+        return nativeError("Argument must be a number array.");
+    }
+    return NUMBER_VAL(AS_NUMBER_ARRAY(args[0])->count);
+}
+
+// 인덱스가 배열 범위 안의 정수인지 검사한다.
+static bool checkIndex(ObjNumberArray* array, Value index) {
+    if (!IS_NUMBER(index)) return false;
+    double number = AS_NUMBER(index);
+    return number >= 0 && number < array->count &&
+           number == (int)number;
+}
+
+static Value arrayGetNative(int argCount, Value* args) {
+    if (!IS_NUMBER_ARRAY(args[0])) {
+        return nativeError("Argument must be a number array.");
+    }
+    ObjNumberArray* array = AS_NUMBER_ARRAY(args[0]);
+    if (!checkIndex(array, args[1])) {
+        return nativeError("Array index out of bounds.");
+    }
+    return NUMBER_VAL(array->values[(int)AS_NUMBER(args[1])]);
+}
+
+// 배열을 돌려주므로 호출을 이어서 쓸 수 있다.
+static Value arraySetNative(int argCount, Value* args) {
+    if (!IS_NUMBER_ARRAY(args[0])) {
+        return nativeError("Argument must be a number array.");
+    }
+    ObjNumberArray* array = AS_NUMBER_ARRAY(args[0]);
+    if (!checkIndex(array, args[1])) {
+        return nativeError("Array index out of bounds.");
+    }
+    if (!IS_NUMBER(args[2])) {
+        return nativeError("Array element must be a number.");
+    }
+    array->values[(int)AS_NUMBER(args[1])] = AS_NUMBER(args[2]);
+    return args[0];
+}
+
+static Value arraySumNative(int argCount, Value* args) {
+    if (!IS_NUMBER_ARRAY(args[0])) {
+        return nativeError("Argument must be a number array.");
+    }
+    return NUMBER_VAL(numberArraySum(AS_NUMBER_ARRAY(args[0])));
+}
+
+static Value arrayMinNative(int argCount, Value* args) {
+    if (!IS_NUMBER_ARRAY(args[0])) {
+        return nativeError("Argument must be a number array.");
+    }
+    if (AS_NUMBER_ARRAY(args[0])->count == 0) {
+        return nativeError("Array is empty.");
+    }
+    return NUMBER_VAL(numberArrayMin(AS_NUMBER_ARRAY(args[0])));
+}
+
+static Value arrayMaxNative(int argCount, Value* args) {
+    if (!IS_NUMBER_ARRAY(args[0])) {
+        return nativeError("Argument must be a number array.");
+    }
+    if (AS_NUMBER_ARRAY(args[0])->count == 0) {
+        return nativeError("Array is empty.");
+    }
+    return NUMBER_VAL(numberArrayMax(AS_NUMBER_ARRAY(args[0])));
+}
+
+// 길이가 같은 숫자 배열 두 개인지 검사한다.
+static bool checkArrayPair(Value a, Value b) {
+    return IS_NUMBER_ARRAY(a) && IS_NUMBER_ARRAY(b) &&
+           AS_NUMBER_ARRAY(a)->count == AS_NUMBER_ARRAY(b)->count;
+}
+
+static Value arrayDotNative(int argCount, Value* args) {
+    if (!checkArrayPair(args[0], args[1])) {
+        return nativeError("Arguments must be number arrays of equal length.");
+    }
+    return NUMBER_VAL(numberArrayDot(AS_NUMBER_ARRAY(args[0]),
+                                     AS_NUMBER_ARRAY(args[1])));
+}
+
+// scale과 add는 새 배열을 만든다.
+static Value arrayScaleNative(int argCount, Value* args) {
+    if (!IS_NUMBER_ARRAY(args[0]) || !IS_NUMBER(args[1])) {
+        return nativeError("Arguments must be a number array and a number.");
+    }
+    ObjNumberArray* array = AS_NUMBER_ARRAY(args[0]);
+    ObjNumberArray* result = newNumberArray(array->count);
+    numberArrayScale(result, array, AS_NUMBER(args[1]));
+    return OBJ_VAL(result);
+}
+
+static Value arrayAddNative(int argCount, Value* args) {
+    if (!checkArrayPair(args[0], args[1])) {
+        return nativeError("Arguments must be number arrays of equal length.");
+    }
+    ObjNumberArray* a = AS_NUMBER_ARRAY(args[0]);
+    ObjNumberArray* result = newNumberArray(a->count);
+    numberArrayAdd(result, a, AS_NUMBER_ARRAY(args[1]));
+    return OBJ_VAL(result);
+}
+
+// 맵
+
+// 리스트 타입이 없으므로 순서 있는 결과는 "0", "1", ... 키를 가진 맵에 담는다.
+static ObjString* indexKey(int index) {
+    char key[16];
+    int keyLength = snprintf(key, sizeof(key), "%d", index);
+    return copyString(key, keyLength);
+}
+
+// map() 또는 map(예상 크기)
+static Value mapNative(int argCount, Value* args) {
+    if (argCount > 1) {
+        return nativeError("Expected 0 or 1 arguments but got %d.",
+                           argCount);
+    }
+    int hint = 0;
+    if (argCount == 1) {
+        if (!checkPosition(args[0], CAPACITY_HINT_MAX)) {
+            return nativeError("Capacity must be an integer between 0 and %d.",
+                               CAPACITY_HINT_MAX);
+        }
+        hint = (int)AS_NUMBER(args[0]);
+    }
+    return OBJ_VAL(newMap(hint));
+}
+
+static bool checkMapKey(Value map, Value key) {
+    return IS_MAP(map) && IS_STRING(key);
+}
+
+// 키가 없으면 nil
+static Value mapGetNative(int argCount, Value* args) {
+    if (!checkMapKey(args[0], args[1])) {
+        return nativeError("Arguments must be a map and a string key.");
+    }
+    Value value;
+    if (!mapGet(AS_MAP(args[0]), AS_STRING(args[1]), &value)) {
+        return NIL_VAL;
+    }
+    return value;
+}
+
+// 맵을 돌려주므로 호출을 이어서 쓸 수 있다.
+static Value mapSetNative(int argCount, Value* args) {
+    if (!checkMapKey(args[0], args[1])) {
+        return nativeError("Arguments must be a map and a string key.");
+    }
+    mapSet(AS_MAP(args[0]), AS_STRING(args[1]), args[2]);
+    return args[0];
+}
+
+static Value mapDeleteNative(int argCount, Value* args) {
+    if (!checkMapKey(args[0], args[1])) {
+        return nativeError("Arguments must be a map and a string key.");
+    }
+    return BOOL_VAL(mapDelete(AS_MAP(args[0]), AS_STRING(args[1])));
+}
+
+// mapMerge(대상, 원본). 원본의 엔트리를 대상에 더하고 대상을 돌려준다.
+static Value mapMergeNative(int argCount, Value* args) {
+    if (!IS_MAP(args[0]) || !IS_MAP(args[1])) {
+        return nativeError("Arguments must be two maps.");
+    }
+    mapMerge(AS_MAP(args[1]), AS_MAP(args[0]));
+    return args[0];
+}
+
+static Value mapSizeNative(int argCount, Value* args) {
+    if (!IS_MAP(args[0])) return nativeError("Argument must be a map.");
+    return NUMBER_VAL(AS_MAP(args[0])->size);
+}
+
+// mapKeys(맵)와 mapValues(맵). 넣은 순서대로 "0", "1", ... 키에 담는다.
+static Value mapEntries(Value map, bool keys) {
+    if (!IS_MAP(map)) return nativeError("Argument must be a map.");
+    ObjMap* source = AS_MAP(map);
+    ObjMap* result = newMap(source->size);
+
+    int cursor = 0;
+    int index = 0;
+    ObjString* key;
+    Value value;
+    while (orderedTableNext(&source->table, &cursor, &key, &value)) {
+        mapSet(result, indexKey(index++), keys ? OBJ_VAL(key) : value);
+    }
+    return OBJ_VAL(result);
+}
+
+static Value mapKeysNative(int argCount, Value* args) {
+    return mapEntries(args[0], true);
+}
+
+static Value mapValuesNative(int argCount, Value* args) {
+    return mapEntries(args[0], false);
+}
+
+// 문자열 빌더
+
+// stringBuilder() 또는 stringBuilder(예상 길이)
+static Value stringBuilderNative(int argCount, Value* args) {
+    if (argCount > 1) {
+        return nativeError("Expected 0 or 1 arguments but got %d.",
+                           argCount);
+    }
+    int hint = 0;
+    if (argCount == 1) {
+        if (!checkPosition(args[0], CAPACITY_HINT_MAX)) {
+            return nativeError("Capacity must be an integer between 0 and %d.",
+                               CAPACITY_HINT_MAX);
+        }
+        hint = (int)AS_NUMBER(args[0]);
+    }
+    return OBJ_VAL(newStringBuilder(hint));
+}
+
+// 빌더를 돌려주므로 호출을 이어서 쓸 수 있다.
+static Value appendNative(int argCount, Value* args) {
+    if (!IS_STRING_BUILDER(args[0])) {
+        return nativeError("Argument must be a string builder.");
+    }
+    ObjStringBuilder* builder = AS_STRING_BUILDER(args[0]);
+    if (IS_STRING(args[1])) {
+        builderAppendString(builder, AS_STRING(args[1]));
+    } else if (IS_NUMBER(args[1])) {
+        builderAppendNumber(builder, AS_NUMBER(args[1]));
+    } else {
+        return nativeError("Can only append strings and numbers.");
+    }
+    return args[0];
+}
+
+static Value buildNative(int argCount, Value* args) {
+    if (!IS_STRING_BUILDER(args[0])) {
+        return nativeError("Argument must be a string builder.");
+    }
+    return OBJ_VAL(builderTakeString(AS_STRING_BUILDER(args[0])));
+}
+
+// 문자열
+
+// length(문자열). 바이트가 아니라 문자 수를 센다. ASCII면 O(1)이다.
+static Value lengthNative(int argCount, Value* args) {
+    if (!IS_STRING(args[0])) {
+        return nativeError("Argument must be a string.");
+    }
+    return NUMBER_VAL(stringCharLength(AS_STRING(args[0])));
+}
+
+// charAt(문자열, 위치). 위치의 문자 하나를 문자열로 돌려준다.
+static Value charAtNative(int argCount, Value* args) {
+    if (!IS_STRING(args[0])) {
+        return nativeError("Argument must be a string.");
+    }
+    ObjString* string = AS_STRING(args[0]);
+    int length = stringCharLength(string);
+    if (!checkPosition(args[1], length - 1)) {
+        return nativeError("String index out of bounds.");
+    }
+    int index = (int)AS_NUMBER(args[1]);
+    int start = stringCharOffset(string, index);
+    int end = stringCharOffset(string, index + 1);
+    return OBJ_VAL(newStringSlice(string, start, end - start));
+}
+
+// substring(문자열, 시작, 끝). 끝은 포함하지 않는다. 위치는 문자 단위다.
+// 결과는 원래 문자열의 저장소를 공유하는 조각이다.
+static Value substringNative(int argCount, Value* args) {
+    if (!IS_STRING(args[0])) {
+        return nativeError("Argument must be a string.");
+    }
+    ObjString* string = AS_STRING(args[0]);
+    int length = stringCharLength(string);
+    if (!checkPosition(args[1], length) ||
+        !checkPosition(args[2], length) ||
+        AS_NUMBER(args[1]) > AS_NUMBER(args[2])) {
+        return nativeError("Substring range out of bounds.");
+    }
+    int start = stringCharOffset(string, (int)AS_NUMBER(args[1]));
+    int end = stringCharOffset(string, (int)AS_NUMBER(args[2]));
+    return OBJ_VAL(newStringSlice(string, start, end - start));
+}
+
+static int findIn(ObjString* string, ObjString* needle, int from) {
+    return findBytes(string->chars, string->length,
+                     needle->chars, needle->length, from);
+}
+
+// find(문자열, 찾을 문자열) 또는 find(문자열, 찾을 문자열, 시작).
+// 처음 나오는 문자 위치를 돌려주고, 없으면 -1이다.
+static Value findNative(int argCount, Value* args) {
+    if (argCount != 2 && argCount != 3) {
+        return nativeError("Expected 2 or 3 arguments but got %d.",
+                           argCount);
+    }
+    if (!IS_STRING(args[0]) || !IS_STRING(args[1])) {
+        return nativeError("Arguments must be two strings.");
+    }
+    ObjString* string = AS_STRING(args[0]);
+
+    int from = 0;
+    if (argCount == 3) {
+        if (!checkPosition(args[2], stringCharLength(string))) {
+            return nativeError("Start position out of bounds.");
+        }
+        from = stringCharOffset(string, (int)AS_NUMBER(args[2]));
+    }
+
+    int offset = findIn(string, AS_STRING(args[1]), from);
+    if (offset == -1) return NUMBER_VAL(-1);
+    return NUMBER_VAL(stringCharIndex(string, offset));
+}
+
+static Value containsNative(int argCount, Value* args) {
+    if (!IS_STRING(args[0]) || !IS_STRING(args[1])) {
+        return nativeError("Arguments must be two strings.");
+    }
+    return BOOL_VAL(findIn(AS_STRING(args[0]), AS_STRING(args[1]), 0) != -1);
+}
+
+// count(문자열, 찾을 문자열). 겹치지 않게 센다.
+static Value countNative(int argCount, Value* args) {
+    if (!IS_STRING(args[0]) || !IS_STRING(args[1])) {
+        return nativeError("Arguments must be two strings.");
+    }
+    ObjString* string = AS_STRING(args[0]);
+    ObjString* needle = AS_STRING(args[1]);
+    if (needle->length == 0) {
+        return nativeError("Search string must not be empty.");
+    }
+
+    int count = 0;
+    int offset = findIn(string, needle, 0);
+    while (offset != -1) {
+        count++;
+        offset = findIn(string, needle, offset + needle->length);
+    }
+    return NUMBER_VAL(count);
+}
+
+static void addPart(ObjMap* parts, int index, ObjString* string,
+                    int start, int end) {
+    mapSet(parts, indexKey(index),
+           OBJ_VAL(newStringSlice(string, start, end - start)));
+}
+
+// split(문자열, 구분자). 조각들을 "0", "1", ... 키로 담은 맵을 돌려준다.
+static Value splitNative(int argCount, Value* args) {
+    if (!IS_STRING(args[0]) || !IS_STRING(args[1])) {
+        return nativeError("Arguments must be two strings.");
+    }
+    ObjString* string = AS_STRING(args[0]);
+    ObjString* separator = AS_STRING(args[1]);
+    if (separator->length == 0) {
+        return nativeError("Separator must not be empty.");
+    }
+
+    ObjMap* parts = newMap(0);
+    int count = 0;
+    int start = 0;
+    int offset = findIn(string, separator, 0);
+    while (offset != -1) {
+        addPart(parts, count++, string, start, offset);
+        start = offset + separator->length;
+        offset = findIn(string, separator, start);
+    }
+    addPart(parts, count, string, start, string->length);
+    return OBJ_VAL(parts);
+}
+
+// 인터닝
+
+static void setStat(ObjMap* stats, const char* name, double value) {
+    mapSet(stats, copyString(name, (int)strlen(name)), NUMBER_VAL(value));
+}
+
+// 인터닝 필터 통계를 맵으로 돌려준다. 필터가 꺼져 있으면 조회 수는 0이다.
+static Value internStatsNative(int argCount, Value* args) {
+    StringFilter filter = vm.stringFilter;
+    ObjMap* stats = newMap(5);
+    setStat(stats, "strings", vm.strings.count);
+    setStat(stats, "lookups", (double)filter.lookups);
+    setStat(stats, "rejected", (double)filter.rejected);
+    setStat(stats, "falsePositives", (double)filter.falsePositives);
+    setStat(stats, "hits", (double)(filter.lookups - filter.rejected -
+                                    filter.falsePositives));
+    return OBJ_VAL(stats);
+}
+
+void defineNatives() {
+    defineNative("clock", 0, clockNative);
+
+    defineNative("numberArray", 1, numberArrayNative);
+    defineNative("arrayLength", 1, arrayLengthNative);
+    defineNative("arrayGet", 2, arrayGetNative);
+    defineNative("arraySet", 3, arraySetNative);
+    defineNative("arraySum", 1, arraySumNative);
+    defineNative("arrayMin", 1, arrayMinNative);
+    defineNative("arrayMax", 1, arrayMaxNative);
+    defineNative("arrayDot", 2, arrayDotNative);
+    defineNative("arrayScale", 2, arrayScaleNative);
+    defineNative("arrayAdd", 2, arrayAddNative);
+
+    defineNative("map", -1, mapNative);
+    defineNative("mapGet", 2, mapGetNative);
+    defineNative("mapSet", 3, mapSetNative);
+    defineNative("mapDelete", 2, mapDeleteNative);
+    defineNative("mapSize", 1, mapSizeNative);
+    defineNative("mapMerge", 2, mapMergeNative);
+    defineNative("mapKeys", 1, mapKeysNative);
+    defineNative("mapValues", 1, mapValuesNative);
+
+    defineNative("stringBuilder", -1, stringBuilderNative);
+    defineNative("append", 2, appendNative);
+    defineNative("build", 1, buildNative);
+
+    defineNative("length", 1, lengthNative);
+    defineNative("charAt", 2, charAtNative);
+    defineNative("substring", 3, substringNative);
+    defineNative("find", -1, findNative);
+    defineNative("contains", 2, containsNative);
+    defineNative("count", 2, countNative);
+    defineNative("split", 2, splitNative);
+
+    defineNative("internStats", 0, internStatsNative);
+}
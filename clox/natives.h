@@ -0,0 +1,7 @@
+#ifndef clox_natives_h
+#define clox_natives_h
+
+// VM이 기본으로 제공하는 네이티브 함수들을 등록한다.
+void defineNatives();
+
+#endif
@@ -0,0 +1,174 @@
+#include "numarray.h"
+
+// 대상 아키텍처마다 벡터 타입과 연산을 같은 이름으로 맞춘다.
+#if defined(__AVX__)
+#include <immintrin.h>
+#define LANES 4
+typedef __m256d Vec;
+#define VEC_SET1(x)         _mm256_set1_pd(x)
+#define VEC_LOAD(p)         _mm256_loadu_pd(p)
+#define VEC_STORE(p, v)     _mm256_storeu_pd(p, v)
+#define VEC_ADD(a, b)       _mm256_add_pd(a, b)
+#define VEC_MUL(a, b)       _mm256_mul_pd(a, b)
+#define VEC_MIN(a, b)       _mm256_min_pd(a, b)
+#define VEC_MAX(a, b)       _mm256_max_pd(a, b)
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LANES 2
+typedef __m128d Vec;
+#define VEC_SET1(x)         _mm_set1_pd(x)
+#define VEC_LOAD(p)         _mm_loadu_pd(p)
+#define VEC_STORE(p, v)     _mm_storeu_pd(p, v)
+#define VEC_ADD(a, b)       _mm_add_pd(a, b)
+#define VEC_MUL(a, b)       _mm_mul_pd(a, b)
+#define VEC_MIN(a, b)       _mm_min_pd(a, b)
+#define VEC_MAX(a, b)       _mm_max_pd(a, b)
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define LANES 2
+typedef float64x2_t Vec;
+#define VEC_SET1(x)         vdupq_n_f64(x)
+#define VEC_LOAD(p)         vld1q_f64(p)
+#define VEC_STORE(p, v)     vst1q_f64(p, v)
+#define VEC_ADD(a, b)       vaddq_f64(a, b)
+#define VEC_MUL(a, b)       vmulq_f64(a, b)
+#define VEC_MIN(a, b)       vminq_f64(a, b)
+#define VEC_MAX(a, b)       vmaxq_f64(a, b)
+#else
+// SIMD가 없으면 레인 하나짜리 스칼라로 돈다.
+#define LANES 1
+typedef double Vec;
+#define VEC_SET1(x)         (x)
+#define VEC_LOAD(p)         (*(p))
+#define VEC_STORE(p, v)     (*(p) = (v))
+#define VEC_ADD(a, b)       ((a) + (b))
+#define VEC_MUL(a, b)       ((a) * (b))
+#define VEC_MIN(a, b)       ((a) < (b) ? (a) : (b))
+#define VEC_MAX(a, b)       ((a) > (b) ? (a) : (b))
+#endif
+
+// 벡터 레인들을 하나로 합친다.
+static double reduceAdd(Vec vec) {
+    double lanes[LANES];
+    VEC_STORE(lanes, vec);
+    double result = lanes[0];
+    for (int i = 1; i < LANES; i++) result += lanes[i];
+    return result;
+}
+
+double numberArraySum(ObjNumberArray* array) {
+    const double* values = array->values;
+    int count = array->count;
+    int i = 0;
+
+    // 덧셈 지연을 숨기려고 누산기를 두 개 쓴다.
+    Vec sum0 = VEC_SET1(0.0);
+    Vec sum1 = VEC_SET1(0.0);
+    for (; i + 2 * LANES <= count; i += 2 * LANES) {
+        sum0 = VEC_ADD(sum0, VEC_LOAD(values + i));
+        sum1 = VEC_ADD(sum1, VEC_LOAD(values + i + LANES));
+    }
+
+    double sum = reduceAdd(VEC_ADD(sum0, sum1));
+    for (; i < count; i++) sum += values[i];
+    return sum;
+}
+
+double numberArrayMin(ObjNumberArray* array) {
+    const double* values = array->values;
+    int count = array->count;
+    int i = 0;
+    double result = values[0];
+
+    if (count >= LANES) {
+        Vec min = VEC_LOAD(values);
+        for (i = LANES; i + LANES <= count; i += LANES) {
+            min = VEC_MIN(min, VEC_LOAD(values + i));
+        }
+
+        double lanes[LANES];
+        VEC_STORE(lanes, min);
+        for (int lane = 0; lane < LANES; lane++) {
+            if (lanes[lane] < result) result = lanes[lane];
+        }
+    }
+
+    for (; i < count; i++) {
+        if (values[i] < result) result = values[i];
+    }
+    return result;
+}
+
+double numberArrayMax(ObjNumberArray* array) {
+    const double* values = array->values;
+    int count = array->count;
+    int i = 0;
+    double result = values[0];
+
+    if (count >= LANES) {
+        Vec max = VEC_LOAD(values);
+        for (i = LANES; i + LANES <= count; i += LANES) {
+            max = VEC_MAX(max, VEC_LOAD(values + i));
+        }
+
+        double lanes[LANES];
+        VEC_STORE(lanes, max);
+        for (int lane = 0; lane < LANES; lane++) {
+            if (lanes[lane] > result) result = lanes[lane];
+        }
+    }
+
+    for (; i < count; i++) {
+        if (values[i] > result) result = values[i];
+    }
+    return result;
+}
+
+double numberArrayDot(ObjNumberArray* a, ObjNumberArray* b) {
+    const double* x = a->values;
+    const double* y = b->values;
+    int count = a->count;
+    int i = 0;
+
+    Vec sum0 = VEC_SET1(0.0);
+    Vec sum1 = VEC_SET1(0.0);
+    for (; i + 2 * LANES <= count; i += 2 * LANES) {
+        sum0 = VEC_ADD(sum0, VEC_MUL(VEC_LOAD(x + i), VEC_LOAD(y + i)));
+        sum1 = VEC_ADD(sum1, VEC_MUL(VEC_LOAD(x + i + LANES),
+                                     VEC_LOAD(y + i + LANES)));
+    }
+
+    double sum = reduceAdd(VEC_ADD(sum0, sum1));
+    for (; i < count; i++) sum += x[i] * y[i];
+    return sum;
+}
+
+void numberArrayScale(ObjNumberArray* dest, ObjNumberArray* array,
+                      double factor) {
+    const double* values = array->values;
+    double* out = dest->values;
+    int count = array->count;
+    int i = 0;
+
+    Vec scale = VEC_SET1(factor);
+    for (; i + LANES <= count; i += LANES) {
+        VEC_STORE(out + i, VEC_MUL(VEC_LOAD(values + i), scale));
+    }
+
+    for (; i < count; i++) out[i] = values[i] * factor;
+}
+
+void numberArrayAdd(ObjNumberArray* dest, ObjNumberArray* a,
+                    ObjNumberArray* b) {
+    const double* x = a->values;
+    const double* y = b->values;
+    double* out = dest->values;
+    int count = a->count;
+    int i = 0;
+
+    for (; i + LANES <= count; i += LANES) {
+        VEC_STORE(out + i, VEC_ADD(VEC_LOAD(x + i), VEC_LOAD(y + i)));
+    }
+
+    for (; i < count; i++) out[i] = x[i] + y[i];
+}
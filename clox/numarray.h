@@ -0,0 +1,21 @@
+#ifndef clox_numarray_h
+#define clox_numarray_h
+
+#include "common.h"
+#include "object.h"
+
+// 숫자 배열 벌크 연산. 빌드 대상이 지원하는 가장 넓은 SIMD 폭으로 돈다.
+// 합과 내적은 레인별로 나눠 더하므로 순차 합과 마지막 자리가 다를 수 있다.
+
+double numberArraySum(ObjNumberArray* array);
+// min/max는 원소가 하나 이상 있어야 한다.
+double numberArrayMin(ObjNumberArray* array);
+double numberArrayMax(ObjNumberArray* array);
+// 아래 연산은 두 배열의 길이가 같아야 한다. dest는 피연산자와 같아도 된다.
+double numberArrayDot(ObjNumberArray* a, ObjNumberArray* b);
+void numberArrayScale(ObjNumberArray* dest, ObjNumberArray* array,
+                      double factor);
+void numberArrayAdd(ObjNumberArray* dest, ObjNumberArray* a,
+                    ObjNumberArray* b);
+
+#endif
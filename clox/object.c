@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "hash.h"
+#include "intern.h"
 #include "memory.h"
 #include "object.h"
 #include "table.h"
@@ -13,61 +15,478 @@
 static Obj* allocateObject(size_t size, ObjType type) {
     Obj* object = (Obj*)reallocate(NULL, 0, size);
     object->type = type;
+    object->isScratch = false;
+    object->isImage = false;
+    object->isShared = false;
+    object->isFrozen = false;
     object->next = vm.objects;
     vm.objects = object;
     return object;
 }
 
-static ObjString* allocateString(char* chars, int length,
+ObjMap* newMap(int capacityHint) {
+    ObjMap* map = ALLOCATE_OBJ(ObjMap, OBJ_MAP);
+    map->size = 0;
+    initOrderedTable(&map->table);
+    // 크기를 미리 알면 한 번에 잡아서 배열을 반복해서 다시 만들지 않는다.
+    if (capacityHint > 0) orderedTableReserve(&map->table, capacityHint);
+    return map;
+}
+
+// 공유 인터닝을 켰으면 공유 테이블에서, 아니면 vm.strings에서 찾는다.
+static ObjString* findHeapString(const char* chars, int length,
                                  uint32_t hash) {
+    if (sharedStringsEnabled()) {
+        return findSharedString(chars, length, hash);
+    }
+
+    StringFilter* filter = &vm.stringFilter;
+    if (filter->bitCount == 0) {
+        return tableFindString(&vm.strings, chars, length, hash);
+    }
+    if (!stringFilterMayContain(filter, hash)) return NULL;
+    ObjString* string = tableFindString(&vm.strings, chars, length, hash);
+    if (string == NULL) filter->falsePositives++;
+    return string;
+}
+
+// 맵 키는 항상 인터닝된 힙 문자열이다. 다른 문자열은 같은 내용의 인터닝된
+// 문자열로 찾고, 그런 문자열이 없으면 어느 맵에도 들어 있을 수 없다.
+static ObjString* heapKey(ObjString* key) {
+    if (key->kind == STRING_INTERNED && !key->obj.isScratch) return key;
+    return findHeapString(key->chars, key->length, stringHash(key));
+}
+
+bool mapGet(ObjMap* map, ObjString* key, Value* value) {
+    key = heapKey(key);
+    return key != NULL && orderedTableGet(&map->table, key, value);
+}
+
+void mapSet(ObjMap* map, ObjString* key, Value value) {
+    key = internString(key);
+    if (orderedTableSet(&map->table, key, promoteValue(value))) map->size++;
+}
+
+bool mapDelete(ObjMap* map, ObjString* key) {
+    key = heapKey(key);
+    if (key == NULL || !orderedTableDelete(&map->table, key)) return false;
+    map->size--;
+    return true;
+}
+
+// 맵의 키와 값은 이미 힙에 있으므로 다시 옮길 필요가 없다.
+void mapMerge(ObjMap* from, ObjMap* to) {
+    to->size += orderedTableAddAll(&from->table, &to->table);
+}
+
+static void printMap(ObjMap* map) {
+    printf("{");
+    int cursor = 0;
+    ObjString* key;
+    Value value;
+    bool first = true;
+    while (orderedTableNext(&map->table, &cursor, &key, &value)) {
+        if (!first) printf(", ");
+        first = false;
+        printf("%s: ", key->chars);
+        printValue(value);
+    }
+    printf("}");
+}
+
+// 원소는 0으로 초기화된다.
+ObjNumberArray* newNumberArray(int count) {
+    if (count < 0 || count > NUMBER_ARRAY_MAX) return NULL;
+
+    ObjNumberArray* array = ALLOCATE_OBJ(ObjNumberArray, OBJ_NUMBER_ARRAY);
+    array->count = 0;
+    array->values = NULL;
+    if (count > 0) {
+        array->values = ALLOCATE(double, count);
+        memset(array->values, 0, sizeof(double) * count);
+    }
+    array->count = count;
+    return array;
+}
+
+static void printNumberArray(ObjNumberArray* array) {
+    printf("[");
+    for (int i = 0; i < array->count; i++) {
+        if (i > 0) printf(", ");
+        printf("%g", array->values[i]);
+    }
+    printf("]");
+}
+
+// 인코딩을 미리 알면 그대로 쓰고, 모르면 설정에 따라 지금 검사한다.
+static uint8_t initialEncoding(const char* chars, int length,
+                               uint8_t known) {
+    if (known != ENCODING_UNKNOWN || !vm.validateStrings) return known;
+    return detectEncoding(chars, length);
+}
+
+static ObjString* allocateString(char* chars, int length,
+                                 uint32_t hash, uint8_t encoding) {
+    if (sharedStringsEnabled()) {
+        return internSharedString(chars, length, hash);
+    }
+
     ObjString* string = ALLOCATE_OBJ(ObjString, OBJ_STRING);
     string->length = length;
     string->chars = chars;
     string->hash = hash;
+    string->kind = STRING_INTERNED;
+    string->hashed = true;
+    string->encoding = initialEncoding(chars, length, encoding);
     tableSet(&vm.strings, string, NIL_VAL);
+    stringFilterAdd(&vm.stringFilter, &vm.strings, hash);
+    return string;
+}
+
+// 헤더와 문자 버퍼를 영역에 한 번에 잡는다. 문자는 호출한 쪽이 채운다.
+static ObjString* allocateScratchString(int length) {
+    ObjString* string = (ObjString*)regionAlloc(&vm.scratch,
+        sizeof(ObjString) + length + 1);
+    string->obj.type = OBJ_STRING;
+    string->obj.isScratch = true;
+    string->obj.isImage = false;
+    string->obj.isShared = false;
+    string->obj.isFrozen = false;
+    string->obj.next = NULL;
+    string->length = length;
+    string->chars = (char*)(string + 1);
+    string->chars[length] = '\0';
+    string->kind = STRING_INTERNED;
+    string->hashed = true;
+    string->encoding = ENCODING_UNKNOWN;
     return string;
 }
 
-// FNV-1a 알고리즘
-static uint32_t hashString(const char* key, int length) {
-    uint32_t hash = 2166136261u;
-    for (int i = 0; i < length; i++) {
-        hash ^= (uint8_t)key[i];
-        hash *= 16777619;
+// 힙 문자열을 먼저 찾고, 실행 중이면 이번 실행의 스크래치 문자열도 찾는다.
+static ObjString* findInterned(const char* chars, int length,
+                               uint32_t hash) {
+    ObjString* interned = findHeapString(chars, length, hash);
+    if (interned == NULL && vm.scratchActive) {
+        interned = tableFindString(&vm.scratchStrings, chars, length, hash);
     }
-    return hash;
+    return interned;
 }
 
-// 기존에 동적 할당된 문자열의 소유권을 가져오는 함수
-ObjString* takeString(char* chars, int length) {
+// 스크래치 문자열을 이번 실행의 인터닝 테이블에 넣고 되감을 때 지울
+// 수 있도록 기록한다.
+static void addScratchString(ObjString* string) {
+    if (vm.scratchKeyCapacity < vm.scratchKeyCount + 1) {
+        int oldCapacity = vm.scratchKeyCapacity;
+        vm.scratchKeyCapacity = GROW_CAPACITY(oldCapacity);
+        vm.scratchKeys = GROW_ARRAY(ObjString*, vm.scratchKeys,
+                                    oldCapacity, vm.scratchKeyCapacity);
+    }
+    vm.scratchKeys[vm.scratchKeyCount++] = string;
+    tableSet(&vm.scratchStrings, string, NIL_VAL);
+}
+
+static ObjString* copyScratchString(const char* chars, int length,
+                                    uint32_t hash, uint8_t encoding) {
+    ObjString* string = allocateScratchString(length);
+    memcpy(string->chars, chars, length);
+    string->hash = hash;
+    string->encoding = initialEncoding(chars, length, encoding);
+    addScratchString(string);
+    return string;
+}
+
+static ObjString* takeEncodedString(char* chars, int length,
+                                    uint8_t encoding) {
     uint32_t hash = hashString(chars, length);
-    ObjString* interned = tableFindString(&vm.strings, chars, length,
-                                           hash);
+    ObjString* interned = findInterned(chars, length, hash);
     if (interned != NULL) {
         FREE_ARRAY(char, chars, length + 1);
         return interned;
     }
 
-    return allocateString(chars, length, hash);
+    if (vm.scratchActive) {
+        ObjString* string = copyScratchString(chars, length, hash, encoding);
+        FREE_ARRAY(char, chars, length + 1);
+        return string;
+    }
+    return allocateString(chars, length, hash, encoding);
+}
+
+// 기존에 동적 할당된 문자열의 소유권을 가져오는 함수
+ObjString* takeString(char* chars, int length) {
+    return takeEncodedString(chars, length, ENCODING_UNKNOWN);
 }
 
 // 소스코드에서 문자열 복사 함수 -> 소유권 없음
 ObjString* copyString(const char* chars, int length) {
     uint32_t hash = hashString(chars, length);
-    ObjString* interned = tableFindString(&vm.strings, chars, length,
-                                          hash);
+    ObjString* interned = findInterned(chars, length, hash);
     if (interned != NULL) return interned;
 
+    if (vm.scratchActive) {
+        return copyScratchString(chars, length, hash, ENCODING_UNKNOWN);
+    }
+
     char* heapChars = ALLOCATE(char, length + 1);
     memcpy(heapChars, chars, length);
     heapChars[length] = '\0';
-    return allocateString(heapChars, length, hash);
+    return allocateString(heapChars, length, hash, ENCODING_UNKNOWN);
+}
+
+// 올바른 UTF-8끼리 이으면 다시 검사하지 않아도 올바르다. 어느 한쪽이라도
+// UTF-8이 아니면 경계에서 문자가 완성될 수 있으므로 모른다고 둔다.
+static uint8_t concatenatedEncoding(ObjString* a, ObjString* b) {
+    if (a->encoding == ENCODING_ASCII && b->encoding == ENCODING_ASCII) {
+        return ENCODING_ASCII;
+    }
+    bool aValid = a->encoding == ENCODING_ASCII ||
+                  a->encoding == ENCODING_UTF8;
+    bool bValid = b->encoding == ENCODING_ASCII ||
+                  b->encoding == ENCODING_UTF8;
+    return aValid && bValid ? ENCODING_UTF8 : ENCODING_UNKNOWN;
+}
+
+// 스크래치 모드에서는 결과를 영역에 바로 이어 쓰고, 이미 인터닝된
+// 문자열이면 방금 잡은 자리를 되돌린다. 힙 할당이 전혀 없다.
+ObjString* concatenateStrings(ObjString* a, ObjString* b) {
+    int length = a->length + b->length;
+    uint8_t encoding = concatenatedEncoding(a, b);
+
+    if (!vm.scratchActive) {
+        char* chars = ALLOCATE(char, length + 1);
+        memcpy(chars, a->chars, a->length);
+        memcpy(chars + a->length, b->chars, b->length);
+        chars[length] = '\0';
+        return takeEncodedString(chars, length, encoding);
+    }
+
+    ObjString* string = allocateScratchString(length);
+    memcpy(string->chars, a->chars, a->length);
+    memcpy(string->chars + a->length, b->chars, b->length);
+    string->hash = hashString(string->chars, length);
+    string->encoding = initialEncoding(string->chars, length, encoding);
+
+    ObjString* interned = findInterned(string->chars, length, string->hash);
+    if (interned != NULL) {
+        regionUnwind(&vm.scratch, sizeof(ObjString) + length + 1);
+        return interned;
+    }
+    addScratchString(string);
+    return string;
+}
+
+// 호스트가 소유한 버퍼를 복사 없이 문자열로 쓴다. 버퍼는 release가
+// 불릴 때까지 살아 있어야 한다. release는 NULL이어도 된다.
+ObjString* newExternalString(const char* chars, int length,
+                             ReleaseFn release, void* context) {
+    ObjExternalString* external = ALLOCATE_OBJ(ObjExternalString,
+                                               OBJ_STRING);
+    external->string.length = length;
+    external->string.chars = (char*)chars;
+    external->string.hash = 0;
+    external->string.kind = STRING_EXTERNAL;
+    external->string.hashed = false;
+    external->string.encoding = initialEncoding(chars, length,
+                                                ENCODING_UNKNOWN);
+    external->release = release;
+    external->context = context;
+    return &external->string;
+}
+
+// 이보다 짧은 조각은 조각 객체보다 복사해서 인터닝하는 쪽이 싸다.
+#define SLICE_MIN_LENGTH 16
+
+// string의 [start, start + length) 범위. 범위 검사는 호출한 쪽이 한다.
+ObjString* newStringSlice(ObjString* string, int start, int length) {
+    if (start == 0 && length == string->length) return string;
+    if (length < SLICE_MIN_LENGTH) {
+        return copyString(string->chars + start, length);
+    }
+
+    // 조각의 조각은 원본을 직접 가리켜서 사슬이 생기지 않게 한다.
+    ObjString* parent = string;
+    if (string->kind == STRING_SLICE) {
+        ObjStringSlice* outer = (ObjStringSlice*)string;
+        parent = outer->parent;
+        start += outer->offset;
+    }
+
+    // 스크래치 문자열의 조각은 부모와 함께 버려지도록 영역에 잡는다.
+    ObjStringSlice* slice;
+    if (parent->obj.isScratch) {
+        slice = (ObjStringSlice*)regionAlloc(&vm.scratch,
+                                             sizeof(ObjStringSlice));
+        slice->string.obj.type = OBJ_STRING;
+        slice->string.obj.isScratch = true;
+        slice->string.obj.isImage = false;
+        slice->string.obj.isShared = false;
+        slice->string.obj.isFrozen = false;
+        slice->string.obj.next = NULL;
+    } else {
+        slice = ALLOCATE_OBJ(ObjStringSlice, OBJ_STRING);
+    }
+
+    slice->string.length = length;
+    slice->string.chars = parent->chars + start;
+    slice->string.hash = 0;
+    slice->string.kind = STRING_SLICE;
+    slice->string.hashed = false;
+    // ASCII의 일부는 ASCII다. 그 밖에는 잘린 자리에 따라 달라진다.
+    slice->string.encoding = initialEncoding(slice->string.chars, length,
+        parent->encoding == ENCODING_ASCII ? ENCODING_ASCII
+                                           : ENCODING_UNKNOWN);
+    slice->parent = parent;
+    slice->offset = start;
+    return &slice->string;
+}
+
+uint32_t stringHash(ObjString* string) {
+    if (!string->hashed) {
+        string->hash = hashString(string->chars, string->length);
+        string->hashed = true;
+    }
+    return string->hash;
+}
+
+StringEncoding stringEncoding(ObjString* string) {
+    if (string->encoding == ENCODING_UNKNOWN) {
+        string->encoding = detectEncoding(string->chars, string->length);
+    }
+    return (StringEncoding)string->encoding;
+}
+
+// 문자 수. ASCII와 UTF-8이 아닌 문자열은 바이트 수와 같아서 O(1)이다.
+int stringCharLength(ObjString* string) {
+    if (stringEncoding(string) != ENCODING_UTF8) return string->length;
+    return utf8Length(string->chars, string->length);
+}
+
+// index번째 문자의 바이트 위치. ASCII면 그대로 index다.
+int stringCharOffset(ObjString* string, int index) {
+    if (stringEncoding(string) != ENCODING_UTF8) return index;
+    return utf8Offset(string->chars, string->length, index);
+}
+
+// 바이트 위치 offset 앞에 있는 문자 수. stringCharOffset의 역이다.
+int stringCharIndex(ObjString* string, int offset) {
+    if (stringEncoding(string) != ENCODING_UTF8) return offset;
+    return utf8Length(string->chars, offset);
+}
+
+// 인터닝된 힙 문자열끼리는 포인터만 비교한다. 스크래치 문자열이나
+// 외부 문자열, 조각이 끼면 같은 내용의 다른 객체가 있을 수 있어 내용을 비교한다.
+bool stringsEqual(ObjString* a, ObjString* b) {
+    if (a == b) return true;
+    if (a->kind == STRING_INTERNED && !a->obj.isScratch &&
+        b->kind == STRING_INTERNED && !b->obj.isScratch) {
+        return false;
+    }
+    return a->length == b->length &&
+           stringHash(a) == stringHash(b) &&
+           memcmp(a->chars, b->chars, a->length) == 0;
+}
+
+// 같은 내용의 인터닝된 힙 문자열을 돌려준다. 없으면 복사해서 만든다.
+ObjString* internString(ObjString* string) {
+    if (string->kind == STRING_INTERNED && !string->obj.isScratch) {
+        return string;
+    }
+
+    uint32_t hash = stringHash(string);
+    ObjString* interned = findHeapString(string->chars, string->length,
+                                         hash);
+    if (interned != NULL) return interned;
+
+    char* heapChars = ALLOCATE(char, string->length + 1);
+    memcpy(heapChars, string->chars, string->length);
+    heapChars[string->length] = '\0';
+    return allocateString(heapChars, string->length, hash,
+                          string->encoding);
+}
+
+// 실행이 끝난 뒤에도 살아야 하는 값에서 스크래치 문자열을 힙으로 옮긴다.
+Value promoteValue(Value value) {
+    if (IS_OBJ(value) && AS_OBJ(value)->isScratch) {
+        return OBJ_VAL(internString(AS_STRING(value)));
+    }
+    return value;
+}
+
+ObjStringBuilder* newStringBuilder(int capacityHint) {
+    ObjStringBuilder* builder = ALLOCATE_OBJ(ObjStringBuilder,
+                                             OBJ_STRING_BUILDER);
+    builder->length = 0;
+    builder->capacity = 0;
+    builder->chars = NULL;
+    if (capacityHint > 0) {
+        builder->chars = ALLOCATE(char, capacityHint);
+        builder->capacity = capacityHint;
+    }
+    return builder;
+}
+
+// 최소 extra 바이트가 더 들어가도록 버퍼를 두 배씩 키운다.
+static void builderReserve(ObjStringBuilder* builder, int extra) {
+    int needed = builder->length + extra;
+    if (needed <= builder->capacity) return;
+
+    int capacity = builder->capacity;
+    while (capacity < needed) capacity = GROW_CAPACITY(capacity);
+    builder->chars = GROW_ARRAY(char, builder->chars,
+                                builder->capacity, capacity);
+    builder->capacity = capacity;
+}
+
+void builderAppend(ObjStringBuilder* builder, const char* chars,
+                   int length) {
+    builderReserve(builder, length);
+    memcpy(builder->chars + builder->length, chars, length);
+    builder->length += length;
+}
+
+void builderAppendString(ObjStringBuilder* builder, ObjString* string) {
+    builderAppend(builder, string->chars, string->length);
+}
+
+// 임시 문자열 없이 버퍼에 바로 포맷한다. printValue()와 같은 %g 형식이다.
+void builderAppendNumber(ObjStringBuilder* builder, double number) {
+    // %g는 최대 "-1.23457e+308" 정도이므로 32바이트면 충분하다.
+    builderReserve(builder, 32);
+    int written = snprintf(builder->chars + builder->length, 32, "%g",
+                           number);
+    builder->length += written;
+}
+
+// 버퍼의 소유권을 새 문자열로 넘기고 빌더는 비운다.
+ObjString* builderTakeString(ObjStringBuilder* builder) {
+    int length = builder->length;
+    char* chars = GROW_ARRAY(char, builder->chars, builder->capacity,
+                             length + 1);
+    chars[length] = '\0';
+
+    builder->chars = NULL;
+    builder->length = 0;
+    builder->capacity = 0;
+    return takeString(chars, length);
 }
 
 void printObject(Value value) {
     switch (OBJ_TYPE(value)) {
-        case OBJ_STRING:
-            printf("%s", AS_CSTRING(value));
+        case OBJ_MAP:
+            printMap(AS_MAP(value));
+            break;
+        case OBJ_NUMBER_ARRAY:
+            printNumberArray(AS_NUMBER_ARRAY(value));
+            break;
+        case OBJ_STRING: {
+            ObjString* string = AS_STRING(value);
+            printf("%.*s", string->length, string->chars);
+            break;
+        }
+        case OBJ_STRING_BUILDER: {
+            ObjStringBuilder* builder = AS_STRING_BUILDER(value);
+            printf("%.*s", builder->length, builder->chars);
             break;
+        }
     }
 }
\ No newline at end of file
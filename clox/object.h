@@ -2,33 +2,140 @@
 #define clox_object_h
 
 #include "common.h"
+#include "ordtable.h"
+#include "table.h"
+#include "utf8.h"
 #include "value.h"
 
 #define OBJ_TYPE(value)         (AS_OBJ(value)->type)
 
+#define IS_MAP(value)           isObjType(value, OBJ_MAP)
+#define IS_NUMBER_ARRAY(value)  isObjType(value, OBJ_NUMBER_ARRAY)
 #define IS_STRING(value)        isObjType(value, OBJ_STRING)
+#define IS_STRING_BUILDER(value) isObjType(value, OBJ_STRING_BUILDER)
 
+#define AS_MAP(value)           ((ObjMap*)AS_OBJ(value))
+#define AS_NUMBER_ARRAY(value)  ((ObjNumberArray*)AS_OBJ(value))
 #define AS_STRING(value)        ((ObjString*)AS_OBJ(value))
 #define AS_CSTRING(value)       (((ObjString*)AS_OBJ(value))->chars)
+#define AS_STRING_BUILDER(value) ((ObjStringBuilder*)AS_OBJ(value))
 
 typedef enum {
+    OBJ_MAP,
+    OBJ_NUMBER_ARRAY,
     OBJ_STRING,
+    OBJ_STRING_BUILDER,
 } ObjType;
 
 struct Obj {
     ObjType type;
+    // 스크래치 영역에 있는 객체. vm.objects에 연결되지 않고 영역과 함께 사라진다.
+    bool isScratch;
+    // 힙 스냅샷 이미지 안에 있는 객체. 객체 자체는 이미지와 함께 해제된다.
+    bool isImage;
+    // 공유 인터닝 테이블이 소유한 문자열. 어느 VM의 objects에도 없다.
+    bool isShared;
+    // 얼린 프로그램의 읽기 전용 매핑 안에 있는 객체. VM이 해제하지 않는다.
+    bool isFrozen;
     struct Obj* next;
 };
 
+typedef enum {
+    // vm.strings에 인터닝된 문자열. 같은 내용이면 같은 포인터다.
+    STRING_INTERNED,
+    // 호스트 버퍼를 그대로 가리킨다. 인터닝되지 않고 해시는 처음 쓸 때 계산한다.
+    STRING_EXTERNAL,
+    // 다른 문자열의 일부를 복사 없이 가리킨다. 인터닝될 때만 복사된다.
+    STRING_SLICE,
+} StringKind;
+
+// chars는 NUL로 끝나지 않을 수 있다. 항상 length와 함께 쓴다.
 struct ObjString {
     Obj obj;
     int length;
     char* chars;
     uint32_t hash;
+    uint8_t kind;
+    bool hashed;
+    // StringEncoding. 처음 필요할 때 검사하고, vm.validateStrings가 켜져
+    // 있으면 만들 때 검사한다.
+    uint8_t encoding;
 };
 
+// 외부 문자열이 해제될 때 호스트에게 버퍼를 돌려주는 콜백
+typedef void (*ReleaseFn)(void* context, const char* chars, int length);
+
+typedef struct {
+    ObjString string;
+    ReleaseFn release;
+    void* context;
+} ObjExternalString;
+
+// 부모는 항상 조각이 아닌 원본 문자열이다. 조각이 부모를 참조하므로
+// 조각이 살아 있는 동안 부모도 해제되지 않는다.
+typedef struct {
+    ObjString string;
+    ObjString* parent;
+    int offset;
+} ObjStringSlice;
+
+// 숫자만 담는 배열. Value 대신 double을 연속으로 저장해서 SIMD로 처리한다.
+typedef struct {
+    Obj obj;
+    int count;
+    double* values;
+} ObjNumberArray;
+
+// 바이트 크기가 int 범위를 넘지 않는 가장 큰 배열
+#define NUMBER_ARRAY_MAX (INT32_MAX / (int)sizeof(double))
+
+// count가 [0, NUMBER_ARRAY_MAX] 밖이면 NULL을 돌려준다.
+ObjNumberArray* newNumberArray(int count);
+
+// 문자열 키 해시 맵. 삽입 순서를 지키는 OrderedTable을 감싸므로
+// 순회와 출력 순서가 넣은 순서와 같다.
+typedef struct {
+    Obj obj;
+    int size;
+    OrderedTable table;
+} ObjMap;
+
+ObjMap* newMap(int capacityHint);
+bool mapGet(ObjMap* map, ObjString* key, Value* value);
+void mapSet(ObjMap* map, ObjString* key, Value value);
+bool mapDelete(ObjMap* map, ObjString* key);
+void mapMerge(ObjMap* from, ObjMap* to);
+
+// 문자열을 이어 붙일 때 쓰는 가변 버퍼. +로 매번 새 문자열을 인터닝하는 대신
+// 버퍼를 두 배씩 키우며 덧붙이고, 끝에 한 번만 문자열로 만든다.
+typedef struct {
+    Obj obj;
+    int length;
+    int capacity;
+    char* chars;
+} ObjStringBuilder;
+
+ObjStringBuilder* newStringBuilder(int capacityHint);
+void builderAppend(ObjStringBuilder* builder, const char* chars,
+                   int length);
+void builderAppendString(ObjStringBuilder* builder, ObjString* string);
+void builderAppendNumber(ObjStringBuilder* builder, double number);
+ObjString* builderTakeString(ObjStringBuilder* builder);
+
 ObjString* takeString(char* chars, int length);
 ObjString* copyString(const char* chars, int length);
+ObjString* newExternalString(const char* chars, int length,
+                             ReleaseFn release, void* context);
+ObjString* newStringSlice(ObjString* string, int start, int length);
+ObjString* concatenateStrings(ObjString* a, ObjString* b);
+uint32_t stringHash(ObjString* string);
+StringEncoding stringEncoding(ObjString* string);
+int stringCharLength(ObjString* string);
+int stringCharOffset(ObjString* string, int index);
+int stringCharIndex(ObjString* string, int offset);
+bool stringsEqual(ObjString* a, ObjString* b);
+ObjString* internString(ObjString* string);
+Value promoteValue(Value value);
 void printObject(Value value);
 
 static inline bool isObjType(Value value, ObjType type) {
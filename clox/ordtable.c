@@ -0,0 +1,233 @@
+#include <string.h>
+
+#include "memory.h"
+#include "object.h"
+#include "ordtable.h"
+
+#define ORDERED_TABLE_MAX_LOAD 0.75
+// Table과 같은 충돌 방어. 넣을 때 이보다 멀리 밀리면 인덱스를 키운다.
+#define ORDERED_TABLE_MAX_PROBE 32
+// 인덱스 크기의 상한. 두 배로 키우다가 int가 넘치지 않게 여기서 멈춘다.
+#define ORDERED_TABLE_MAX_INDEX (1 << 30)
+
+void initOrderedTable(OrderedTable* table) {
+    table->count = 0;
+    table->live = 0;
+    table->capacity = 0;
+    table->entries = NULL;
+    table->indexCapacity = 0;
+    table->index = NULL;
+}
+
+// 인덱스 칸 하나의 바이트 수. 엔트리는 인덱스 용량의 3/4까지이므로
+// 엔트리 번호 + 1이 들어갈 만큼만 쓴다.
+static size_t indexWidth(int indexCapacity) {
+    if (indexCapacity <= 256) return sizeof(uint8_t);
+    if (indexCapacity <= 65536) return sizeof(uint16_t);
+    return sizeof(uint32_t);
+}
+
+void freeOrderedTable(OrderedTable* table) {
+    FREE_ARRAY(Entry, table->entries, table->capacity);
+    reallocate(table->index,
+               indexWidth(table->indexCapacity) * table->indexCapacity, 0);
+    initOrderedTable(table);
+}
+
+static inline uint32_t getSlot(OrderedTable* table, uint32_t slot) {
+    switch (indexWidth(table->indexCapacity)) {
+        case sizeof(uint8_t):  return ((uint8_t*)table->index)[slot];
+        case sizeof(uint16_t): return ((uint16_t*)table->index)[slot];
+        default:               return ((uint32_t*)table->index)[slot];
+    }
+}
+
+static inline void setSlot(OrderedTable* table, uint32_t slot,
+                           uint32_t value) {
+    switch (indexWidth(table->indexCapacity)) {
+        case sizeof(uint8_t):  ((uint8_t*)table->index)[slot] = value; break;
+        case sizeof(uint16_t): ((uint16_t*)table->index)[slot] = value; break;
+        default:               ((uint32_t*)table->index)[slot] = value; break;
+    }
+}
+
+// key가 있는 인덱스 칸, 없으면 key를 넣을 빈 칸. *probes에 탐색 거리를 남긴다.
+// 지운 엔트리를 가리키는 칸은 툼스톤처럼 지나간다.
+static uint32_t findSlot(OrderedTable* table, ObjString* key, int* probes) {
+    uint32_t mask = (uint32_t)table->indexCapacity - 1;
+    uint32_t slot = key->hash & mask;
+    int distance = 0;
+    for (;;) {
+        uint32_t entry = getSlot(table, slot);
+        if (entry == 0 || table->entries[entry - 1].key == key) {
+            if (probes != NULL) *probes = distance;
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+        distance++;
+    }
+}
+
+// 지운 엔트리를 빼고 앞으로 모은 뒤 인덱스를 새 크기로 다시 만든다.
+static void rebuild(OrderedTable* table, int indexCapacity) {
+    int capacity = (int)(indexCapacity * ORDERED_TABLE_MAX_LOAD);
+    Entry* entries = ALLOCATE(Entry, capacity);
+    int count = 0;
+    for (int i = 0; i < table->count; i++) {
+        if (table->entries[i].key == NULL) continue;
+        entries[count++] = table->entries[i];
+    }
+    FREE_ARRAY(Entry, table->entries, table->capacity);
+    reallocate(table->index,
+               indexWidth(table->indexCapacity) * table->indexCapacity, 0);
+
+    table->entries = entries;
+    table->capacity = capacity;
+    table->count = count;
+    table->live = count;
+    table->indexCapacity = indexCapacity;
+    size_t indexSize = indexWidth(indexCapacity) * indexCapacity;
+    table->index = reallocate(NULL, 0, indexSize);
+    memset(table->index, 0, indexSize);
+
+    for (int i = 0; i < count; i++) {
+        setSlot(table, findSlot(table, entries[i].key, NULL), i + 1);
+    }
+}
+
+// 새 키의 탐색이 ORDERED_TABLE_MAX_PROBE칸을 넘으면 인덱스를 다시 만든다.
+// 지운 칸이 탐색을 늘린 것이면 모으기만 하고, 아니면 키운다.
+// 키가 들어갈 인덱스 칸을 돌려준다.
+static uint32_t limitProbes(OrderedTable* table, ObjString* key,
+                            uint32_t slot, int probes) {
+    if (probes <= ORDERED_TABLE_MAX_PROBE ||
+        table->indexCapacity >= table->live * 8) {
+        return slot;
+    }
+
+    bool holes = table->count - table->live > table->live / 4;
+    rebuild(table, holes ? table->indexCapacity
+                         : table->indexCapacity * 2);
+    return findSlot(table, key, NULL);
+}
+
+bool orderedTableGet(OrderedTable* table, ObjString* key, Value* value) {
+    if (table->live == 0) return false;
+
+    uint32_t entry = getSlot(table, findSlot(table, key, NULL));
+    if (entry == 0) return false;
+    *value = table->entries[entry - 1].value;
+    return true;
+}
+
+bool orderedTableSet(OrderedTable* table, ObjString* key, Value value) {
+    if (table->count == table->capacity) {
+        // 지운 칸이 절반을 넘으면 크기는 그대로 두고 모으기만 한다.
+        int indexCapacity = table->indexCapacity;
+        if (indexCapacity == 0) {
+            indexCapacity = 8;
+        } else if (table->live >= table->capacity / 2) {
+            indexCapacity *= 2;
+        }
+        rebuild(table, indexCapacity);
+    }
+
+    int probes;
+    uint32_t slot = findSlot(table, key, &probes);
+    uint32_t entry = getSlot(table, slot);
+    if (entry != 0) {
+        table->entries[entry - 1].value = value;
+        return false;
+    }
+
+    slot = limitProbes(table, key, slot, probes);
+    table->entries[table->count].key = key;
+    table->entries[table->count].value = value;
+    table->count++;
+    table->live++;
+    setSlot(table, slot, table->count);
+    return true;
+}
+
+bool orderedTableDelete(OrderedTable* table, ObjString* key) {
+    if (table->live == 0) return false;
+
+    uint32_t entry = getSlot(table, findSlot(table, key, NULL));
+    if (entry == 0) return false;
+
+    // 인덱스 칸은 그대로 두어야 뒤에 있는 키의 탐색이 끊기지 않는다.
+    table->entries[entry - 1].key = NULL;
+    table->entries[entry - 1].value = NIL_VAL;
+    table->live--;
+    return true;
+}
+
+// count개가 로드 팩터 안에 들어가는 인덱스 크기
+static int indexCapacityFor(OrderedTable* table, int count) {
+    int indexCapacity = table->indexCapacity < 8 ? 8 : table->indexCapacity;
+    while (count > indexCapacity * ORDERED_TABLE_MAX_LOAD &&
+           indexCapacity < ORDERED_TABLE_MAX_INDEX) {
+        indexCapacity *= 2;
+    }
+    return indexCapacity;
+}
+
+void orderedTableReserve(OrderedTable* table, int count) {
+    if (count <= table->capacity) return;
+    rebuild(table, indexCapacityFor(table, count));
+}
+
+// count개의 엔트리를 배열 순서대로 한 번에 넣는다. 키가 NULL인 칸은 건너뛰고
+// 이미 있는 키는 값만 바뀐다. 배열은 한 번만 다시 만들고 각 엔트리는 로드
+// 팩터 검사 없이 바로 붙인다. 탐색 길이 제한은 orderedTableSet과 똑같이
+// 받는다. 새로 생긴 키의 수를 돌려준다.
+int orderedTableSetAll(OrderedTable* table, const Entry* entries,
+                       int count) {
+    if (table->count + count > table->capacity) {
+        rebuild(table, indexCapacityFor(table, table->live + count));
+    }
+
+    int added = 0;
+    for (int i = 0; i < count; i++) {
+        const Entry* entry = &entries[i];
+        if (entry->key == NULL) continue;
+
+        int probes;
+        uint32_t slot = findSlot(table, entry->key, &probes);
+        uint32_t existing = getSlot(table, slot);
+        if (existing != 0) {
+            table->entries[existing - 1].value = entry->value;
+            continue;
+        }
+        slot = limitProbes(table, entry->key, slot, probes);
+        table->entries[table->count++] = *entry;
+        table->live++;
+        setSlot(table, slot, table->count);
+        added++;
+    }
+    return added;
+}
+
+// from의 엔트리를 넣은 순서대로 to에 더한다. 새로 생긴 키의 수를 돌려준다.
+int orderedTableAddAll(OrderedTable* from, OrderedTable* to) {
+    // 자기 자신과 합치면 바뀌는 것이 없다. 다시 만들다가 읽던 배열을
+    // 해제하지 않도록 여기서 끝낸다.
+    if (from == to) return 0;
+    return orderedTableSetAll(to, from->entries, from->count);
+}
+
+bool orderedTableNext(OrderedTable* table, int* cursor, ObjString** key,
+                      Value* value) {
+    for (int i = *cursor; i < table->count; i++) {
+        Entry* entry = &table->entries[i];
+        if (entry->key == NULL) continue;
+
+        *key = entry->key;
+        *value = entry->value;
+        *cursor = i + 1;
+        return true;
+    }
+
+    *cursor = table->count;
+    return false;
+}
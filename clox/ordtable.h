@@ -0,0 +1,36 @@
+#ifndef clox_ordtable_h
+#define clox_ordtable_h
+
+#include "common.h"
+#include "table.h"
+#include "value.h"
+
+// 삽입 순서를 지키는 압축 해시 테이블. 엔트리는 넣은 순서대로 빽빽한
+// 배열에 쌓고, 해시 탐색은 엔트리 번호만 담은 작은 인덱스 배열로 한다.
+// 인덱스 칸은 용량에 따라 8/16/32비트다. 빈 칸 없이 엔트리를 모아 두므로
+// Table보다 메모리가 적고, 순회는 배열을 앞에서부터 읽기만 하면 된다.
+//
+// 삭제한 엔트리는 키를 NULL로 비워 두고 다음에 배열을 다시 만들 때 없앤다.
+typedef struct {
+    int count;         // 엔트리 배열에서 쓴 칸 수. 지운 칸도 센다.
+    int live;          // 살아 있는 엔트리 수
+    int capacity;      // 엔트리 배열 용량
+    Entry* entries;
+    int indexCapacity; // 2의 거듭제곱
+    void* index;       // 0은 빈 칸, 그 밖에는 엔트리 번호 + 1
+} OrderedTable;
+
+void initOrderedTable(OrderedTable* table);
+void freeOrderedTable(OrderedTable* table);
+bool orderedTableGet(OrderedTable* table, ObjString* key, Value* value);
+bool orderedTableSet(OrderedTable* table, ObjString* key, Value value);
+bool orderedTableDelete(OrderedTable* table, ObjString* key);
+void orderedTableReserve(OrderedTable* table, int count);
+int orderedTableSetAll(OrderedTable* table, const Entry* entries,
+                       int count);
+int orderedTableAddAll(OrderedTable* from, OrderedTable* to);
+// 넣은 순서대로 순회한다. *cursor를 0으로 시작해서 false가 나올 때까지 부른다.
+bool orderedTableNext(OrderedTable* table, int* cursor, ObjString** key,
+                      Value* value);
+
+#endif
@@ -0,0 +1,73 @@
+#include "memory.h"
+#include "region.h"
+
+#define REGION_BLOCK_SIZE (64 * 1024)
+
+// 모든 할당을 8바이트 경계에 맞춘다.
+#define ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+void initRegion(Region* region) {
+    region->first = NULL;
+    region->current = NULL;
+}
+
+void freeRegion(Region* region) {
+    RegionBlock* block = region->first;
+    while (block != NULL) {
+        RegionBlock* next = block->next;
+        reallocate(block, sizeof(RegionBlock) + block->size, 0);
+        block = next;
+    }
+    initRegion(region);
+}
+
+static RegionBlock* newBlock(size_t size) {
+    RegionBlock* block = (RegionBlock*)reallocate(NULL, 0,
+        sizeof(RegionBlock) + size);
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+void* regionAlloc(Region* region, size_t size) {
+    size = ALIGN(size);
+    RegionBlock* block = region->current;
+
+    if (block == NULL || block->used + size > block->size) {
+        // 되감은 뒤라면 이미 잡아 둔 다음 블록을 다시 쓴다.
+        if (block != NULL && block->next != NULL &&
+            block->next->size >= size) {
+            block = block->next;
+            block->used = 0;
+        } else {
+            RegionBlock* fresh = newBlock(
+                size > REGION_BLOCK_SIZE ? size : REGION_BLOCK_SIZE);
+            if (block == NULL) {
+                fresh->next = region->first;
+                region->first = fresh;
+            } else {
+                fresh->next = block->next;
+                block->next = fresh;
+            }
+            block = fresh;
+        }
+        region->current = block;
+    }
+
+    void* result = block->data + block->used;
+    block->used += size;
+    return result;
+}
+
+void regionUnwind(Region* region, size_t size) {
+    size = ALIGN(size);
+    RegionBlock* block = region->current;
+    if (block != NULL && block->used >= size) block->used -= size;
+}
+
+// 블록 수와 상관없이 O(1)이다. 뒤쪽 블록의 used는 다시 쓸 때 0으로 돌린다.
+void resetRegion(Region* region) {
+    region->current = region->first;
+    if (region->current != NULL) region->current->used = 0;
+}
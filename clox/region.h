@@ -0,0 +1,28 @@
+#ifndef clox_region_h
+#define clox_region_h
+
+#include "common.h"
+
+// 범프 할당 영역. 할당은 포인터를 밀기만 하고 개별 해제는 없다.
+// resetRegion()은 블록을 돌려주지 않고 처음으로 되감기만 하므로
+// 같은 크기의 작업을 반복하면 malloc을 다시 부르지 않는다.
+typedef struct RegionBlock {
+    struct RegionBlock* next;
+    size_t size;
+    size_t used;
+    char data[];
+} RegionBlock;
+
+typedef struct {
+    RegionBlock* first;
+    RegionBlock* current;
+} Region;
+
+void initRegion(Region* region);
+void freeRegion(Region* region);
+void* regionAlloc(Region* region, size_t size);
+// 바로 직전에 할당한 size 바이트를 되돌린다.
+void regionUnwind(Region* region, size_t size);
+void resetRegion(Region* region);
+
+#endif
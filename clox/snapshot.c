@@ -0,0 +1,473 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash.h"
+#include "intern.h"
+#include "memory.h"
+#include "object.h"
+#include "snapshot.h"
+#include "table.h"
+#include "vm.h"
+
+#define SNAPSHOT_VERSION 2
+
+// 이미지 안의 모든 블록을 8바이트 경계에 맞춘다.
+#define ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+// 구조체 배치가 다른 빌드에서 만든 이미지를 거부하기 위한 값
+#define LAYOUT_FINGERPRINT \
+    ((uint32_t)(sizeof(void*) | sizeof(Value) << 8 | \
+                sizeof(ObjString) << 16 | sizeof(ObjMap) << 24))
+
+// 헤더의 위치 값은 모두 이미지 시작에서의 오프셋이다. 0은 없음을 뜻한다.
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t layout;
+    uint32_t globalCount;
+    uint64_t size;
+    uint64_t objects;           // 첫 객체. 나머지는 next로 이어진다.
+    uint64_t strings;           // 인터닝된 문자열 포인터 배열
+    uint64_t stringCount;
+    uint64_t globalValues;      // Value 배열
+    uint64_t globalIdentifiers; // 슬롯 이름 Value 배열
+    uint64_t fixups;            // 보정할 포인터 위치 배열
+    uint64_t fixupCount;
+} SnapshotHeader;
+
+typedef struct {
+    uint8_t* data;
+    size_t size;
+    uint64_t* fixups;
+    size_t fixupCount;
+    size_t fixupCapacity;
+    // 객체 주소 -> 이미지 오프셋. 열린 주소법, 용량은 2의 거듭제곱이다.
+    Obj** keys;
+    uint64_t* offsets;
+    size_t capacity;
+    // VM 힙 밖의 객체(얼린 프로그램의 상수 등)를 참조하면 저장할 수 없다.
+    bool failed;
+} Writer;
+
+static size_t slotFor(Writer* writer, Obj* object) {
+    size_t mask = writer->capacity - 1;
+    size_t index = ((uintptr_t)object >> 4) & mask;
+    while (writer->keys[index] != NULL && writer->keys[index] != object) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+static uint64_t offsetOf(Writer* writer, Obj* object) {
+    size_t slot = slotFor(writer, object);
+    if (writer->keys[slot] == NULL) {
+        writer->failed = true;
+        return 0;
+    }
+    return writer->offsets[slot];
+}
+
+// 문자를 객체 바로 뒤에 붙여 저장하는 문자열에서 문자가 시작하는 위치
+static size_t inlineCharsOffset(ObjString* string) {
+    return string->kind == STRING_EXTERNAL ? sizeof(ObjExternalString)
+                                           : sizeof(ObjString);
+}
+
+static size_t objectSize(Obj* object) {
+    switch (object->type) {
+        case OBJ_MAP:
+            return sizeof(ObjMap) + sizeof(Entry) * ((ObjMap*)object)->size;
+        case OBJ_NUMBER_ARRAY:
+            return sizeof(ObjNumberArray) +
+                   sizeof(double) * ((ObjNumberArray*)object)->count;
+        case OBJ_STRING: {
+            ObjString* string = (ObjString*)object;
+            if (string->kind == STRING_SLICE) return sizeof(ObjStringSlice);
+            return inlineCharsOffset(string) + string->length + 1;
+        }
+        case OBJ_STRING_BUILDER:
+            return sizeof(ObjStringBuilder) +
+                   ((ObjStringBuilder*)object)->capacity;
+    }
+    return 0; // 실행되지 않는 코드
+}
+
+static void addFixup(Writer* writer, uint64_t at) {
+    if (writer->fixupCount == writer->fixupCapacity) {
+        size_t capacity = GROW_CAPACITY(writer->fixupCapacity);
+        writer->fixups = GROW_ARRAY(uint64_t, writer->fixups,
+                                    writer->fixupCapacity, capacity);
+        writer->fixupCapacity = capacity;
+    }
+    writer->fixups[writer->fixupCount++] = at;
+}
+
+// at 위치의 포인터 필드에 이미지 오프셋을 쓴다.
+static void writeOffset(Writer* writer, uint64_t at, uint64_t offset) {
+    uintptr_t value = (uintptr_t)offset;
+    memcpy(writer->data + at, &value, sizeof(value));
+    if (offset != 0) addFixup(writer, at);
+}
+
+static void writePointer(Writer* writer, uint64_t at, Obj* object) {
+    writeOffset(writer, at, object == NULL ? 0 : offsetOf(writer, object));
+}
+
+static void writeValue(Writer* writer, uint64_t at, Value value) {
+    memcpy(writer->data + at, &value, sizeof(Value));
+    if (IS_OBJ(value)) {
+        writePointer(writer, at + offsetof(Value, as), AS_OBJ(value));
+    }
+}
+
+static void writeString(Writer* writer, ObjString* string, uint64_t at) {
+    if (string->kind == STRING_SLICE) {
+        ObjStringSlice* slice = (ObjStringSlice*)string;
+        memcpy(writer->data + at, slice, sizeof(ObjStringSlice));
+        writePointer(writer, at + offsetof(ObjStringSlice, parent),
+                     (Obj*)slice->parent);
+        writeOffset(writer, at + offsetof(ObjString, chars),
+                    offsetOf(writer, (Obj*)slice->parent) +
+                    inlineCharsOffset(slice->parent) + slice->offset);
+        return;
+    }
+
+    uint64_t chars = at + inlineCharsOffset(string);
+    if (string->kind == STRING_EXTERNAL) {
+        // 호스트 버퍼는 이미지에 복사되고 해제 콜백은 따라가지 않는다.
+        ObjExternalString copy = *(ObjExternalString*)string;
+        copy.release = NULL;
+        copy.context = NULL;
+        memcpy(writer->data + at, &copy, sizeof(copy));
+    } else {
+        memcpy(writer->data + at, string, sizeof(ObjString));
+    }
+    memcpy(writer->data + chars, string->chars, string->length);
+    writer->data[chars + string->length] = '\0';
+    writeOffset(writer, at + offsetof(ObjString, chars), chars);
+}
+
+static void writeObject(Writer* writer, Obj* object, uint64_t at) {
+    switch (object->type) {
+        case OBJ_MAP: {
+            // 테이블은 살아 있는 엔트리만 빽빽하게 저장하고 읽을 때 다시 만든다.
+            ObjMap* map = (ObjMap*)object;
+            memcpy(writer->data + at, map, sizeof(ObjMap));
+            uint64_t pairs = at + sizeof(ObjMap);
+            ObjMap* copy = (ObjMap*)(writer->data + at);
+            copy->table.count = map->size;
+            copy->table.live = map->size;
+            copy->table.capacity = 0;
+            copy->table.indexCapacity = 0;
+            writeOffset(writer, at + offsetof(ObjMap, table.entries),
+                        map->size > 0 ? pairs : 0);
+            writeOffset(writer, at + offsetof(ObjMap, table.index), 0);
+
+            int cursor = 0;
+            ObjString* key;
+            Value value;
+            while (orderedTableNext(&map->table, &cursor, &key, &value)) {
+                writePointer(writer, pairs + offsetof(Entry, key),
+                             (Obj*)key);
+                writeValue(writer, pairs + offsetof(Entry, value), value);
+                pairs += sizeof(Entry);
+            }
+            break;
+        }
+        case OBJ_NUMBER_ARRAY: {
+            ObjNumberArray* array = (ObjNumberArray*)object;
+            memcpy(writer->data + at, array, sizeof(ObjNumberArray));
+            uint64_t values = at + sizeof(ObjNumberArray);
+            memcpy(writer->data + values, array->values,
+                   sizeof(double) * array->count);
+            writeOffset(writer, at + offsetof(ObjNumberArray, values),
+                        array->count > 0 ? values : 0);
+            break;
+        }
+        case OBJ_STRING:
+            writeString(writer, (ObjString*)object, at);
+            break;
+        case OBJ_STRING_BUILDER: {
+            ObjStringBuilder* builder = (ObjStringBuilder*)object;
+            memcpy(writer->data + at, builder, sizeof(ObjStringBuilder));
+            uint64_t chars = at + sizeof(ObjStringBuilder);
+            memcpy(writer->data + chars, builder->chars, builder->length);
+            writeOffset(writer, at + offsetof(ObjStringBuilder, chars),
+                        builder->capacity > 0 ? chars : 0);
+            break;
+        }
+    }
+
+    Obj* header = (Obj*)(writer->data + at);
+    header->isScratch = false;
+    header->isImage = true;
+    header->isShared = false;
+    header->isFrozen = false;
+    writePointer(writer, at + offsetof(Obj, next), object->next);
+}
+
+bool saveSnapshot(const char* path) {
+    // 공유 문자열은 VM의 객체 목록에 없어서 이미지에 담을 수 없다.
+    if (sharedStringsEnabled()) {
+        fprintf(stderr, "Snapshots require per-VM string interning.\n");
+        return false;
+    }
+
+    Writer writer;
+    writer.fixups = NULL;
+    writer.fixupCount = 0;
+    writer.fixupCapacity = 0;
+    writer.failed = false;
+
+    // 객체마다 이미지 안의 위치를 먼저 정한다.
+    size_t objectCount = 0;
+    for (Obj* object = vm.objects; object != NULL; object = object->next) {
+        objectCount++;
+    }
+    writer.capacity = 8;
+    while (writer.capacity < objectCount * 2) writer.capacity *= 2;
+    writer.keys = ALLOCATE(Obj*, writer.capacity);
+    writer.offsets = ALLOCATE(uint64_t, writer.capacity);
+    memset(writer.keys, 0, sizeof(Obj*) * writer.capacity);
+
+    size_t size = ALIGN(sizeof(SnapshotHeader));
+    for (Obj* object = vm.objects; object != NULL; object = object->next) {
+        size_t slot = slotFor(&writer, object);
+        writer.keys[slot] = object;
+        writer.offsets[slot] = size;
+        size += ALIGN(objectSize(object));
+    }
+
+    size_t strings = size;
+    size += ALIGN(sizeof(ObjString*) * vm.strings.count);
+    size_t globalValues = size;
+    size += sizeof(Value) * vm.globalValues.count;
+    size_t globalIdentifiers = size;
+    size += sizeof(Value) * vm.globalIdentifiers.count;
+
+    writer.size = size;
+    writer.data = ALLOCATE(uint8_t, size);
+    memset(writer.data, 0, size);
+
+    for (Obj* object = vm.objects; object != NULL; object = object->next) {
+        writeObject(&writer, object, offsetOf(&writer, object));
+    }
+
+    uint64_t stringCount = 0;
+    int cursor = 0;
+    ObjString* key;
+    Value value;
+    while (tableNext(&vm.strings, &cursor, &key, &value)) {
+        writePointer(&writer, strings + sizeof(ObjString*) * stringCount++,
+                     (Obj*)key);
+    }
+
+    for (int i = 0; i < vm.globalValues.count; i++) {
+        writeValue(&writer, globalValues + sizeof(Value) * i,
+                   vm.globalValues.values[i]);
+        writeValue(&writer, globalIdentifiers + sizeof(Value) * i,
+                   vm.globalIdentifiers.values[i]);
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "CLXS", 4);
+    header.version = SNAPSHOT_VERSION;
+    header.layout = LAYOUT_FINGERPRINT;
+    header.globalCount = (uint32_t)vm.globalValues.count;
+    header.size = size + sizeof(uint64_t) * writer.fixupCount;
+    header.objects = vm.objects == NULL ? 0 : offsetOf(&writer, vm.objects);
+    header.strings = strings;
+    header.stringCount = stringCount;
+    header.globalValues = globalValues;
+    header.globalIdentifiers = globalIdentifiers;
+    header.fixups = size;
+    header.fixupCount = writer.fixupCount;
+    memcpy(writer.data, &header, sizeof(header));
+
+    bool ok = false;
+    FILE* file = writer.failed ? NULL : fopen(path, "wb");
+    if (writer.failed) {
+        fprintf(stderr, "Snapshot refers to objects outside the heap.\n");
+    } else if (file != NULL) {
+        ok = fwrite(writer.data, 1, size, file) == size &&
+             fwrite(writer.fixups, sizeof(uint64_t), writer.fixupCount,
+                    file) == writer.fixupCount;
+        ok = fclose(file) == 0 && ok;
+    }
+
+    FREE_ARRAY(uint8_t, writer.data, size);
+    FREE_ARRAY(uint64_t, writer.fixups, writer.fixupCapacity);
+    FREE_ARRAY(Obj*, writer.keys, writer.capacity);
+    FREE_ARRAY(uint64_t, writer.offsets, writer.capacity);
+    return ok;
+}
+
+// 해시 시드는 프로세스마다 다르므로 저장된 해시는 쓸 수 없다.
+// 맵을 다시 만들기 전에 모든 문자열의 해시를 새로 계산한다.
+static void rehashString(Obj* object) {
+    if (object->type != OBJ_STRING) return;
+    ObjString* string = (ObjString*)object;
+    if (string->kind == STRING_SLICE) {
+        string->hashed = false;
+    } else {
+        string->hash = hashString(string->chars, string->length);
+        string->hashed = true;
+    }
+}
+
+// 이미지의 객체 중 커질 수 있는 버퍼는 힙으로 옮긴다.
+// 문자열과 숫자 배열은 이미지 안에 그대로 둔다.
+static void adoptObject(Obj* object) {
+    switch (object->type) {
+        case OBJ_MAP: {
+            ObjMap* map = (ObjMap*)object;
+            Entry* pairs = map->table.entries;
+            int count = map->table.count;
+            initOrderedTable(&map->table);
+            orderedTableReserve(&map->table, count);
+            for (int i = 0; i < count; i++) {
+                orderedTableSet(&map->table, pairs[i].key, pairs[i].value);
+            }
+            break;
+        }
+        case OBJ_STRING_BUILDER: {
+            ObjStringBuilder* builder = (ObjStringBuilder*)object;
+            if (builder->capacity == 0) break;
+            char* chars = ALLOCATE(char, builder->capacity);
+            memcpy(chars, builder->chars, builder->length);
+            builder->chars = chars;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// 새 인터닝 테이블은 이미지의 문자열로 만든다. VM에 이미 있던 문자열은
+// 이미지에 같은 내용이 없을 때만 남기고, 네이티브 이름은 새 테이블의
+// 문자열로 바꿔서 포인터 비교가 계속 맞도록 한다.
+static void adoptStrings(ObjString** strings, uint64_t count) {
+    Table interned;
+    initTable(&interned);
+    tableReserve(&interned, (int)count + vm.strings.count);
+    for (uint64_t i = 0; i < count; i++) {
+        tableSet(&interned, strings[i], NIL_VAL);
+    }
+
+    int cursor = 0;
+    ObjString* key;
+    Value value;
+    while (tableNext(&vm.strings, &cursor, &key, &value)) {
+        if (tableFindString(&interned, key->chars, key->length,
+                            key->hash) == NULL) {
+            tableSet(&interned, key, NIL_VAL);
+        }
+    }
+
+    freeTable(&vm.nativeNames);
+    for (int i = 0; i < vm.nativeCount; i++) {
+        Native* native = &vm.natives[i];
+        native->name = tableFindString(&interned, native->name->chars,
+                                       native->name->length,
+                                       native->name->hash);
+        tableSet(&vm.nativeNames, native->name, NUMBER_VAL(i));
+    }
+
+    freeTable(&vm.strings);
+    vm.strings = interned;
+    if (vm.stringFilter.bitCount > 0) {
+        buildStringFilter(&vm.stringFilter, &vm.strings);
+    }
+}
+
+bool loadSnapshot(const char* path) {
+    if (sharedStringsEnabled()) {
+        fprintf(stderr, "Snapshots require per-VM string interning.\n");
+        return false;
+    }
+    if (vm.image != NULL || vm.globalValues.count != 0) {
+        fprintf(stderr, "Snapshot must be loaded into a fresh VM.\n");
+        return false;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 ||
+        (size_t)info.st_size < sizeof(SnapshotHeader)) {
+        close(fd);
+        return false;
+    }
+
+    // 쓰기 시 복사로 매핑해서 보정과 이후 수정이 파일에 반영되지 않게 한다.
+    size_t size = (size_t)info.st_size;
+    uint8_t* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                         fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return false;
+
+    SnapshotHeader* header = (SnapshotHeader*)base;
+    if (memcmp(header->magic, "CLXS", 4) != 0 ||
+        header->version != SNAPSHOT_VERSION ||
+        header->layout != LAYOUT_FINGERPRINT ||
+        header->size != size ||
+        header->fixups + sizeof(uint64_t) * header->fixupCount != size) {
+        munmap(base, size);
+        return false;
+    }
+
+    uint64_t* fixups = (uint64_t*)(base + header->fixups);
+    for (uint64_t i = 0; i < header->fixupCount; i++) {
+        if (fixups[i] > header->fixups - sizeof(uintptr_t)) {
+            munmap(base, size);
+            return false;
+        }
+        uintptr_t* pointer = (uintptr_t*)(base + fixups[i]);
+        *pointer += (uintptr_t)base;
+    }
+
+    vm.image = base;
+    vm.imageSize = size;
+
+    if (header->objects != 0) {
+        Obj* first = (Obj*)(base + header->objects);
+        for (Obj* object = first; object != NULL; object = object->next) {
+            rehashString(object);
+        }
+        Obj* last = first;
+        for (Obj* object = first; object != NULL; object = object->next) {
+            adoptObject(object);
+            last = object;
+        }
+        last->next = vm.objects;
+        vm.objects = first;
+    }
+
+    adoptStrings((ObjString**)(base + header->strings), header->stringCount);
+
+    // 이름 테이블은 한 번에 채운다.
+    Value* values = (Value*)(base + header->globalValues);
+    Value* identifiers = (Value*)(base + header->globalIdentifiers);
+    Entry* names = ALLOCATE(Entry, header->globalCount);
+    for (uint32_t i = 0; i < header->globalCount; i++) {
+        writeValueArray(&vm.globalValues, values[i]);
+        writeValueArray(&vm.globalIdentifiers, identifiers[i]);
+        names[i].key = AS_STRING(identifiers[i]);
+        names[i].value = NUMBER_VAL(i);
+    }
+    tableSetAll(&vm.globalNames, names, (int)header->globalCount);
+    FREE_ARRAY(Entry, names, header->globalCount);
+    return true;
+}
+
+void unloadSnapshot() {
+    if (vm.image == NULL) return;
+    munmap(vm.image, vm.imageSize);
+    vm.image = NULL;
+    vm.imageSize = 0;
+}
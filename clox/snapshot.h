@@ -0,0 +1,18 @@
+#ifndef clox_snapshot_h
+#define clox_snapshot_h
+
+#include "common.h"
+
+// 힙 스냅샷. 객체, 인터닝 테이블, 전역 변수를 하나의 이미지 파일로 저장하고
+// 나중에 mmap 한 번과 포인터 보정만으로 되살린다.
+//
+// 이미지 안의 포인터는 이미지 시작에서의 오프셋으로 저장되고, 보정할 위치의
+// 목록이 파일 끝에 붙는다. 같은 빌드에서 만든 이미지만 읽을 수 있다.
+
+bool saveSnapshot(const char* path);
+// initVM() 직후, 전역을 정의하거나 interpret()를 부르기 전에만 쓸 수 있다.
+bool loadSnapshot(const char* path);
+// freeVM()이 객체를 모두 해제한 뒤에 부른다.
+void unloadSnapshot();
+
+#endif
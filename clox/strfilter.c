@@ -0,0 +1,90 @@
+#include <string.h>
+
+#include "memory.h"
+#include "object.h"
+#include "strfilter.h"
+
+// 문자열 하나에 16비트, 비트 3개. 오탐률은 0.5% 정도다.
+#define FILTER_BITS_PER_STRING 16
+#define FILTER_MIN_BITS 1024
+
+void initStringFilter(StringFilter* filter) {
+    filter->bits = NULL;
+    filter->bitCount = 0;
+    filter->count = 0;
+    filter->lookups = 0;
+    filter->rejected = 0;
+    filter->falsePositives = 0;
+}
+
+void freeStringFilter(StringFilter* filter) {
+    FREE_ARRAY(uint64_t, filter->bits, filter->bitCount / 64);
+    initStringFilter(filter);
+}
+
+#define FILTER_HASHES 3
+
+// 해시 하나에서 이중 해싱으로 비트 위치 세 개를 만든다.
+static inline void bitPositions(StringFilter* filter, uint32_t hash,
+                                uint32_t* positions) {
+    uint32_t mask = filter->bitCount - 1;
+    uint32_t step = (hash >> 17 | hash << 15) | 1;
+    for (int i = 0; i < FILTER_HASHES; i++) {
+        positions[i] = (hash + i * step) & mask;
+    }
+}
+
+static void setBits(StringFilter* filter, uint32_t hash) {
+    uint32_t positions[FILTER_HASHES];
+    bitPositions(filter, hash, positions);
+    for (int i = 0; i < FILTER_HASHES; i++) {
+        filter->bits[positions[i] / 64] |= (uint64_t)1 << (positions[i] % 64);
+    }
+}
+
+void buildStringFilter(StringFilter* filter, Table* strings) {
+    uint32_t bitCount = FILTER_MIN_BITS;
+    while (bitCount < (uint32_t)strings->count * FILTER_BITS_PER_STRING) {
+        bitCount *= 2;
+    }
+
+    FREE_ARRAY(uint64_t, filter->bits, filter->bitCount / 64);
+    filter->bits = ALLOCATE(uint64_t, bitCount / 64);
+    memset(filter->bits, 0, sizeof(uint64_t) * (bitCount / 64));
+    filter->bitCount = bitCount;
+    filter->count = 0;
+
+    for (int i = 0; i < strings->capacity; i++) {
+        ObjString* key = strings->entries[i].key;
+        if (key == NULL) continue;
+        setBits(filter, key->hash);
+        filter->count++;
+    }
+}
+
+void stringFilterAdd(StringFilter* filter, Table* strings, uint32_t hash) {
+    if (filter->bitCount == 0) return;
+    if ((uint32_t)(filter->count + 1) * FILTER_BITS_PER_STRING >
+        filter->bitCount) {
+        // 비트는 지울 수 없으므로 테이블에서 다시 만든다. 새 문자열은
+        // 이미 테이블에 들어 있다.
+        buildStringFilter(filter, strings);
+        return;
+    }
+    setBits(filter, hash);
+    filter->count++;
+}
+
+bool stringFilterMayContain(StringFilter* filter, uint32_t hash) {
+    filter->lookups++;
+    uint32_t positions[FILTER_HASHES];
+    bitPositions(filter, hash, positions);
+    for (int i = 0; i < FILTER_HASHES; i++) {
+        uint64_t mask = (uint64_t)1 << (positions[i] % 64);
+        if ((filter->bits[positions[i] / 64] & mask) == 0) {
+            filter->rejected++;
+            return false;
+        }
+    }
+    return true;
+}
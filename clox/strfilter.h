@@ -0,0 +1,28 @@
+#ifndef clox_strfilter_h
+#define clox_strfilter_h
+
+#include "common.h"
+#include "table.h"
+
+// 인터닝 테이블 앞에 두는 블룸 필터. 문자열마다 해시로 고른 비트 세 개를
+// 켜 두고, 셋 중 하나라도 꺼져 있으면 테이블을 탐색하지 않고 바로 없다고
+// 판단한다. 처음 보는 문자열이 많은 작업에서 헛탐색을 줄인다.
+typedef struct {
+    uint64_t* bits;
+    uint32_t bitCount; // 2의 거듭제곱. 0이면 필터를 쓰지 않는다.
+    int count;
+    // 통계
+    uint64_t lookups;        // 필터를 거친 조회 수
+    uint64_t rejected;       // 필터만으로 없다고 끝낸 조회 수
+    uint64_t falsePositives; // 필터는 통과했지만 테이블에 없던 조회 수
+} StringFilter;
+
+void initStringFilter(StringFilter* filter);
+void freeStringFilter(StringFilter* filter);
+// strings에 든 문자열로 필터를 새로 만든다. 통계는 유지한다.
+void buildStringFilter(StringFilter* filter, Table* strings);
+// 문자열이 늘어 오탐률이 올라가면 strings로 필터를 키워서 다시 만든다.
+void stringFilterAdd(StringFilter* filter, Table* strings, uint32_t hash);
+bool stringFilterMayContain(StringFilter* filter, uint32_t hash);
+
+#endif
@@ -0,0 +1,53 @@
+#include <string.h>
+
+#include "bytevec.h"
+#include "strsearch.h"
+
+static int findByte(const char* haystack, int length, char byte, int from) {
+    int i = from;
+    ByteVec target = BYTES_SET1(byte);
+    while (i + BYTE_LANES <= length) {
+        uint32_t mask = BYTES_EQ_MASK(BYTES_LOAD(haystack + i), target);
+        if (mask != 0) return i + firstLane(mask);
+        i += BYTE_LANES;
+    }
+    for (; i < length; i++) {
+        if (haystack[i] == byte) return i;
+    }
+    return -1;
+}
+
+int findBytes(const char* haystack, int length,
+              const char* needle, int needleLength, int from) {
+    if (needleLength == 0) return from <= length ? from : -1;
+    if (needleLength == 1) return findByte(haystack, length, needle[0], from);
+
+    int last = needleLength - 1;
+    ByteVec first = BYTES_SET1(needle[0]);
+    ByteVec final = BYTES_SET1(needle[last]);
+
+    // 후보 위치 i에 대해 haystack[i + last]까지 읽으므로 그만큼 덜 돈다.
+    int i = from;
+    while (i + last + BYTE_LANES <= length) {
+        uint32_t mask =
+            BYTES_EQ_MASK(BYTES_LOAD(haystack + i), first) &
+            BYTES_EQ_MASK(BYTES_LOAD(haystack + i + last), final);
+        while (mask != 0) {
+            int candidate = i + firstLane(mask);
+            if (memcmp(haystack + candidate + 1, needle + 1,
+                       needleLength - 2) == 0) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+        i += BYTE_LANES;
+    }
+
+    for (; i + last < length; i++) {
+        if (haystack[i] == needle[0] && haystack[i + last] == needle[last] &&
+            memcmp(haystack + i + 1, needle + 1, needleLength - 2) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
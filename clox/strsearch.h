@@ -0,0 +1,13 @@
+#ifndef clox_strsearch_h
+#define clox_strsearch_h
+
+#include "common.h"
+
+// haystack[from..length)에서 needle이 처음 나오는 바이트 위치. 없으면 -1
+//
+// 블록마다 needle의 첫 바이트와 마지막 바이트를 벡터로 한 번에 비교하고,
+// 둘 다 맞는 자리만 나머지 바이트를 비교한다.
+int findBytes(const char* haystack, int length,
+              const char* needle, int needleLength, int from);
+
+#endif
@@ -8,6 +8,10 @@
 
 #define TABLE_MAX_LOAD 0.75 // 테이블의 로드 팩터
 
+// 새 키를 넣을 때 이보다 멀리 밀려나면 충돌이 몰린 것으로 보고 테이블을
+// 키워서 다시 해시한다. 용량이 키 수의 8배가 되면 더 키우지 않는다.
+#define TABLE_MAX_PROBE 32
+
 void initTable(Table* table) {
     table->count = 0;
     table->capacity = 0;
@@ -19,6 +23,31 @@ void freeTable(Table* table) {
     initTable(table);
 }
 
+// 용량은 그대로 두고 모든 엔트리를 비운다.
+void tableClear(Table* table) {
+    for (int i = 0; i < table->capacity; i++) {
+        table->entries[i].key = NULL;
+        table->entries[i].value = NIL_VAL;
+    }
+    table->count = 0;
+}
+
+static Entry* findEntry(Entry* entries, int capacity,
+                        ObjString* key);
+
+// 넣은 키들만 빈 칸으로 되돌려서 테이블을 비운다. 비용은 용량이 아니라
+// 키 수에 비례한다. keys는 테이블의 모든 키를 넣은 순서대로 담아야 하고,
+// 그동안 키를 지우거나 용량을 바꾸지 않았어야 한다. 나중에 넣은 키부터
+// 지우므로 각 키의 탐색 경로는 지울 때까지 그대로 남아 있다.
+void tableClearKeys(Table* table, ObjString** keys, int count) {
+    for (int i = count - 1; i >= 0; i--) {
+        Entry* entry = findEntry(table->entries, table->capacity, keys[i]);
+        entry->key = NULL;
+        entry->value = NIL_VAL;
+    }
+    table->count = 0;
+}
+
 static Entry* findEntry(Entry* entries, int capacity,
                         ObjString* key) {
     uint32_t index = key->hash % capacity;
@@ -76,13 +105,25 @@ static void adjustCapacity(Table* table, int capacity) {
     table->capacity = capacity;
 }
 
-bool tableSet(Table* table, ObjString* key, Value value) {
-    if (table->count + 1 > table->capacity * TABLE_MAX_LOAD) {
-        int capacity = GROW_CAPACITY(table->capacity);
-        adjustCapacity(table, capacity);
+// 새 키가 제 자리에서 TABLE_MAX_PROBE칸 넘게 밀려났으면 테이블을 키우고
+// 다시 찾는다. 해시 충돌을 노린 입력이 탐색을 길게 만들지 못하게 한다.
+static Entry* limitProbes(Table* table, ObjString* key, Entry* entry) {
+    int home = (int)(key->hash % table->capacity);
+    int probes = ((int)(entry - table->entries) - home +
+                  table->capacity) % table->capacity;
+    if (probes > TABLE_MAX_PROBE && table->capacity < table->count * 8) {
+        adjustCapacity(table, table->capacity * 2);
+        entry = findEntry(table->entries, table->capacity, key);
     }
+    return entry;
+}
+
+// 로드 팩터를 검사하지 않고 넣는다. 호출한 쪽이 용량을 미리 잡아 둔다.
+// 벌크 삽입도 이 길을 지나므로 탐색 길이 제한을 똑같이 받는다.
+static bool placeEntry(Table* table, ObjString* key, Value value) {
     Entry* entry = findEntry(table->entries, table->capacity, key);
     bool isNewKey = entry->key == NULL;
+    if (isNewKey) entry = limitProbes(table, key, entry);
     if (isNewKey && IS_NIL(entry->value)) table->count++;
 
     entry->key = key;
@@ -90,6 +131,41 @@ bool tableSet(Table* table, ObjString* key, Value value) {
     return isNewKey;
 }
 
+bool tableSet(Table* table, ObjString* key, Value value) {
+    if (table->count + 1 > table->capacity * TABLE_MAX_LOAD) {
+        int capacity = GROW_CAPACITY(table->capacity);
+        adjustCapacity(table, capacity);
+    }
+    return placeEntry(table, key, value);
+}
+
+// count개의 엔트리가 로드 팩터를 넘지 않도록 미리 배열을 키워둔다.
+void tableReserve(Table* table, int count) {
+    int capacity = table->capacity;
+    while (count > capacity * TABLE_MAX_LOAD) {
+        capacity = GROW_CAPACITY(capacity);
+    }
+
+    if (capacity > table->capacity) adjustCapacity(table, capacity);
+}
+
+// 엔트리 순회. *cursor를 0으로 시작해서 false가 나올 때까지 부른다.
+// 순서는 해시 순서이고, 순회 중에 테이블을 바꾸면 안 된다.
+bool tableNext(Table* table, int* cursor, ObjString** key, Value* value) {
+    for (int i = *cursor; i < table->capacity; i++) {
+        Entry* entry = &table->entries[i];
+        if (entry->key == NULL) continue;
+
+        *key = entry->key;
+        *value = entry->value;
+        *cursor = i + 1;
+        return true;
+    }
+
+    *cursor = table->capacity;
+    return false;
+}
+
 bool tableDelete(Table* table, ObjString* key) {
     if (table->count == 0) return false;
 
@@ -104,15 +180,40 @@ bool tableDelete(Table* table, ObjString* key) {
 }
 
 void tableAddAll(Table* from, Table* to) {
-    // from과 to 의 배열 길이는 같아야함.
+    // 비어 있는 같은 크기의 테이블이면 배열을 그대로 복사한다. 해시와 용량이
+    // 같으므로 모든 키가 원래 슬롯에 있게 된다. 툼스톤도 count와 함께 따라간다.
+    // 배치가 from과 같으므로 탐색 길이도 from이 받은 제한을 그대로 따른다.
+    if (to->count == 0 && to->capacity == from->capacity) {
+        if (from->capacity > 0) {
+            memcpy(to->entries, from->entries,
+                   sizeof(Entry) * from->capacity);
+        }
+        to->count = from->count;
+        return;
+    }
+
+    // from->count는 툼스톤도 세므로 넉넉한 상한이다. 한 번만 키운다.
+    tableReserve(to, to->count + from->count);
     for (int i = 0; i < from->capacity; i++) {
         Entry* entry = &from->entries[i];
         if (entry->key != NULL) {
-            tableSet(to, entry->key, entry->value);
+            placeEntry(to, entry->key, entry->value);
         }
     }
 }
 
+// 여러 엔트리를 한 번에 넣는다. 용량은 한 번만 잡고 각 엔트리는
+// placeEntry로 넣으므로 탐색 길이 제한은 tableSet과 똑같다.
+// 새로 생긴 키의 수를 돌려준다.
+int tableSetAll(Table* table, const Entry* entries, int count) {
+    tableReserve(table, table->count + count);
+    int added = 0;
+    for (int i = 0; i < count; i++) {
+        if (placeEntry(table, entries[i].key, entries[i].value)) added++;
+    }
+    return added;
+}
+
 ObjString* tableFindString(Table* table, const char* chars,
                            int length, uint32_t hash) {
     if (table->count == 0) return NULL;
@@ -17,10 +17,15 @@ typedef struct {
 
 void initTable(Table* table);
 void freeTable(Table* table);
+void tableClear(Table* table);
+void tableClearKeys(Table* table, ObjString** keys, int count);
 bool tableGet(Table* table, ObjString* key, Value* value);
 bool tableSet(Table* table, ObjString* Key, Value value);
 bool tableDelete(Table* table, ObjString* key);
 void tableAddAll(Table* from, Table* to);
+int tableSetAll(Table* table, const Entry* entries, int count);
+void tableReserve(Table* table, int count);
+bool tableNext(Table* table, int* cursor, ObjString** key, Value* value);
 ObjString* tableFindString(Table* table, const char* chars,
                            int length, uint32_t hash);
 
@@ -0,0 +1,82 @@
+#include "bytevec.h"
+#include "utf8.h"
+
+// 0x80 이상 바이트가 처음 나오는 위치. 없으면 length
+static int skipAscii(const char* chars, int start, int length) {
+    int i = start;
+    while (i + BYTE_LANES <= length &&
+           BYTES_HIGH_MASK(BYTES_LOAD(chars + i)) == 0) {
+        i += BYTE_LANES;
+    }
+    while (i < length && (uint8_t)chars[i] < 0x80) i++;
+    return i;
+}
+
+StringEncoding detectEncoding(const char* chars, int length) {
+    bool ascii = true;
+    int i = skipAscii(chars, 0, length);
+    while (i < length) {
+        ascii = false;
+        uint8_t lead = (uint8_t)chars[i];
+        int continuation;
+        uint32_t codePoint;
+        uint32_t minimum;
+        if ((lead & 0xe0) == 0xc0) {
+            continuation = 1;
+            codePoint = lead & 0x1f;
+            minimum = 0x80;
+        } else if ((lead & 0xf0) == 0xe0) {
+            continuation = 2;
+            codePoint = lead & 0x0f;
+            minimum = 0x800;
+        } else if ((lead & 0xf8) == 0xf0) {
+            continuation = 3;
+            codePoint = lead & 0x07;
+            minimum = 0x10000;
+        } else {
+            return ENCODING_BINARY;
+        }
+
+        if (i + continuation >= length) return ENCODING_BINARY;
+        for (int k = 1; k <= continuation; k++) {
+            uint8_t byte = (uint8_t)chars[i + k];
+            if ((byte & 0xc0) != 0x80) return ENCODING_BINARY;
+            codePoint = codePoint << 6 | (byte & 0x3f);
+        }
+
+        // 너무 긴 인코딩, 서로게이트, 유니코드 범위 밖은 받지 않는다.
+        if (codePoint < minimum || codePoint > 0x10ffff ||
+            (codePoint >= 0xd800 && codePoint <= 0xdfff)) {
+            return ENCODING_BINARY;
+        }
+
+        i = skipAscii(chars, i + continuation + 1, length);
+    }
+    return ascii ? ENCODING_ASCII : ENCODING_UTF8;
+}
+
+// 이어지는 바이트(10xxxxxx)가 아닌 바이트마다 문자가 하나 시작한다.
+int utf8Length(const char* chars, int length) {
+    int count = 0;
+    int i = 0;
+    while (i < length) {
+        int next = skipAscii(chars, i, length);
+        count += next - i;
+        i = next;
+        if (i < length) {
+            if (((uint8_t)chars[i] & 0xc0) != 0x80) count++;
+            i++;
+        }
+    }
+    return count;
+}
+
+int utf8Offset(const char* chars, int length, int index) {
+    int count = 0;
+    for (int i = 0; i < length; i++) {
+        if (((uint8_t)chars[i] & 0xc0) == 0x80) continue;
+        if (count == index) return i;
+        count++;
+    }
+    return length;
+}
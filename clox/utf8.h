@@ -0,0 +1,21 @@
+#ifndef clox_utf8_h
+#define clox_utf8_h
+
+#include "common.h"
+
+typedef enum {
+    ENCODING_UNKNOWN, // 아직 검사하지 않았다.
+    ENCODING_ASCII,   // 모든 바이트가 0x80 미만. 문자 위치 = 바이트 위치
+    ENCODING_UTF8,    // 올바른 UTF-8
+    ENCODING_BINARY,  // UTF-8이 아니다. 바이트 하나를 문자 하나로 본다.
+} StringEncoding;
+
+// ASCII 구간은 벡터 단위로 건너뛰고 ASCII가 아닌 곳만 한 글자씩 검사한다.
+StringEncoding detectEncoding(const char* chars, int length);
+// 올바른 UTF-8 문자열의 문자 수
+int utf8Length(const char* chars, int length);
+// 올바른 UTF-8 문자열에서 index번째 문자의 바이트 위치.
+// index가 문자 수와 같으면 length를 돌려준다.
+int utf8Offset(const char* chars, int length, int index);
+
+#endif
@@ -34,18 +34,28 @@ void printValue(Value value) {
             printf(AS_BOOL(value) ? "true" : "false");
             break;
         case VAL_NIL: printf("nil"); break;
-        case VAL_NUMBER: printf("%g", AS_NUMBER(value));
+        case VAL_NUMBER: printf("%g", AS_DOUBLE(value)); break;
+        // 큰 정수도 double과 똑같이 보이도록 %g로 출력한다.
+        case VAL_INT: printf("%g", (double)AS_INT(value)); break;
         case VAL_OBJ: printObject(value); break;
+        case VAL_UNDEFINED: printf("<undefined>"); break;
     }
 }
 
 bool valuesEqual(Value a, Value b) {
+    if (IS_NUMBER(a) && IS_NUMBER(b)) {
+        if (IS_INT(a) && IS_INT(b)) return AS_INT(a) == AS_INT(b);
+        return AS_NUMBER(a) == AS_NUMBER(b);
+    }
     if (a.type != b.type) return false;
     switch (a.type) {
         case VAL_BOOL:    return AS_BOOL(a) == AS_BOOL(b);
         case VAL_NIL:     return true;
-        case VAL_NUMBER:  return AS_NUMBER(a) == AS_NUMBER(b);
-        case VAL_OBJ:     return AS_OBJ(a) == AS_OBJ(b);
+        case VAL_OBJ:
+            if (AS_OBJ(a) == AS_OBJ(b)) return true;
+            if (!IS_STRING(a) || !IS_STRING(b)) return false;
+            return stringsEqual(AS_STRING(a), AS_STRING(b));
+        case VAL_UNDEFINED: return true;
         default:          return false; // 실행되지 않는 코드
     }
 }
\ No newline at end of file
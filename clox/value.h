@@ -10,7 +10,9 @@ typedef enum {
     VAL_BOOL,
     VAL_NIL,
     VAL_NUMBER,
-    VAL_OBJ
+    VAL_INT,  // 정수 범위의 숫자. 관찰되는 의미는 VAL_NUMBER와 같다.
+    VAL_OBJ,
+    VAL_UNDEFINED // 아직 정의되지 않은 전역 슬롯. 스크립트에는 보이지 않는다.
 } ValueType;
 
 typedef struct {
@@ -18,23 +20,36 @@ typedef struct {
     union {
         bool boolean;
         double number;
+        int32_t integer;
         Obj* obj;
     } as;
 } Value;
 
 #define IS_BOOL(value)      ((value).type == VAL_BOOL)
 #define IS_NIL(value)       ((value).type == VAL_NIL)
-#define IS_NUMBER(value)    ((value).type == VAL_NUMBER)
+#define IS_DOUBLE(value)    ((value).type == VAL_NUMBER)
+#define IS_INT(value)       ((value).type == VAL_INT)
+#define IS_NUMBER(value)    (IS_DOUBLE(value) || IS_INT(value))
 #define IS_OBJ(value)       ((value).type == VAL_OBJ)
+#define IS_UNDEFINED(value) ((value).type == VAL_UNDEFINED)
 
 #define AS_OBJ(value)       ((value).as.obj)
 #define AS_BOOL(value)      ((value).as.boolean)
-#define AS_NUMBER(value)    ((value).as.number)
+#define AS_DOUBLE(value)    ((value).as.number)
+#define AS_INT(value)       ((value).as.integer)
+#define AS_NUMBER(value)    valueAsNumber(value)
 
 #define BOOL_VAL(value)     ((Value){VAL_BOOL, {.boolean = value}})
 #define NIL_VAL             ((Value){VAL_NIL, {.number = 0}})
 #define NUMBER_VAL(value)   ((Value){VAL_NUMBER, {.number = value}})
+#define INT_VAL(value)      ((Value){VAL_INT, {.integer = value}})
 #define OBJ_VAL(object)     ((Value){VAL_OBJ, {.obj = (Obj*)object}})
+#define UNDEFINED_VAL       ((Value){VAL_UNDEFINED, {.number = 0}})
+
+// 정수든 double이든 Lox 숫자로서의 값을 돌려준다.
+static inline double valueAsNumber(Value value) {
+    return IS_INT(value) ? (double)AS_INT(value) : AS_DOUBLE(value);
+}
 
 typedef struct {
     int capacity;
@@ -6,8 +6,11 @@
 #include "compiler.h"
 #include "vm.h"
 #include "debug.h"
+#include "hash.h"
 #include "object.h"
 #include "memory.h"
+#include "natives.h"
+#include "snapshot.h"
 
 VM vm;
 
@@ -29,14 +32,104 @@ static void runtimeError(const char* format, ...) {
 }
 
 void initVM() {
+    initHashSeed();
     resetStack();
     vm.objects = NULL;
     initTable(&vm.strings);
+    initStringFilter(&vm.stringFilter);
+    vm.validateStrings = false;
+    initTable(&vm.globalNames);
+    initValueArray(&vm.globalValues);
+    initValueArray(&vm.globalIdentifiers);
+
+    vm.scratchMode = false;
+    vm.scratchActive = false;
+    initRegion(&vm.scratch);
+    initTable(&vm.scratchStrings);
+    vm.scratchKeys = NULL;
+    vm.scratchKeyCount = 0;
+    vm.scratchKeyCapacity = 0;
+    vm.image = NULL;
+    vm.imageSize = 0;
+
+    vm.nativeCount = 0;
+    vm.nativeFailed = false;
+    initTable(&vm.nativeNames);
+    defineNatives();
 }
 
 void freeVM() {
     freeTable(&vm.strings);
+    freeStringFilter(&vm.stringFilter);
+    freeTable(&vm.globalNames);
+    freeValueArray(&vm.globalValues);
+    freeValueArray(&vm.globalIdentifiers);
+    freeTable(&vm.nativeNames);
+    freeTable(&vm.scratchStrings);
+    FREE_ARRAY(ObjString*, vm.scratchKeys, vm.scratchKeyCapacity);
+    freeRegion(&vm.scratch);
     freeObjects();
+    unloadSnapshot();
+}
+
+// 이름에 해당하는 전역 슬롯 인덱스. 처음 보는 이름이면 정의되지 않은
+// 슬롯을 새로 만든다. 정의보다 사용이 먼저 컴파일되어도 같은 슬롯을 가리킨다.
+int globalSlotFor(ObjString* name) {
+    Value index;
+    if (tableGet(&vm.globalNames, name, &index)) {
+        return (int)AS_NUMBER(index);
+    }
+
+    int slot = vm.globalValues.count;
+    writeValueArray(&vm.globalValues, UNDEFINED_VAL);
+    writeValueArray(&vm.globalIdentifiers, OBJ_VAL(name));
+    tableSet(&vm.globalNames, name, NUMBER_VAL(slot));
+    return slot;
+}
+
+// 호스트가 스크립트에 값을 넘길 때 쓴다. newExternalString()과 함께 쓰면
+// 큰 문자열을 복사하지 않고 전역으로 노출할 수 있다.
+void defineGlobal(const char* name, Value value) {
+    int slot = globalSlotFor(copyString(name, (int)strlen(name)));
+    vm.globalValues.values[slot] = value;
+}
+
+// 처음 보는 문자열이 많은 작업에서 인터닝 조회를 줄인다. 언제 켜도 된다.
+void enableStringFilter() {
+    buildStringFilter(&vm.stringFilter, &vm.strings);
+}
+
+// 컴파일러가 이름을 찾을 수 있도록 interpret() 전에 등록해야 한다.
+// 같은 이름을 다시 등록하면 덮어쓴다.
+void defineNative(const char* name, int arity, NativeFn function) {
+    ObjString* nameString = copyString(name, (int)strlen(name));
+
+    Value index;
+    if (!tableGet(&vm.nativeNames, nameString, &index)) {
+        if (vm.nativeCount == NATIVES_MAX) {
+            fprintf(stderr, "Too many native functions.\n");
+            return;
+        }
+        index = NUMBER_VAL(vm.nativeCount++);
+        tableSet(&vm.nativeNames, nameString, index);
+    }
+
+    Native* native = &vm.natives[(int)AS_NUMBER(index)];
+    native->name = nameString;
+    native->function = function;
+    native->arity = arity;
+}
+
+// 네이티브 안에서 return nativeError(...); 로 쓴다.
+// 호출이 끝나면 VM이 런타임 에러로 바꿔서 보고한다.
+Value nativeError(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(vm.nativeErrorMessage, sizeof(vm.nativeErrorMessage),
+              format, args);
+    va_end(args);
+    vm.nativeFailed = true;
+    return NIL_VAL;
 }
 
 void push(Value value) {
@@ -60,29 +153,65 @@ static bool isFalsey(Value value) {
 static void concatenate() {
     ObjString* b = AS_STRING(pop());
     ObjString* a = AS_STRING(pop());
+    push(OBJ_VAL(concatenateStrings(a, b)));
+}
 
-    int length = a->length + b->length;
-    char* chars = ALLOCATE(char, length + 1);
-    memcpy(chars, a->chars, a->length);
-    memcpy(chars + a->length, b->chars, b->length);
-    chars[length] = '\0';
+// 정수 연산 결과가 int32 범위를 벗어나면 double로 넘어간다.
+static inline Value intResult(int64_t result) {
+    if (result < INT32_MIN || result > INT32_MAX) {
+        return NUMBER_VAL((double)result);
+    }
+    return INT_VAL((int32_t)result);
+}
 
-    ObjString* result = takeString(chars, length);
-    push(OBJ_VAL(result));
+// double에서는 0에 음수를 곱하면 -0이 된다. 정수로는 표현할 수 없다.
+static inline Value intMultiply(int32_t a, int32_t b) {
+    int64_t result = (int64_t)a * b;
+    if (result == 0 && (a < 0) != (b < 0)) return NUMBER_VAL(-0.0);
+    return intResult(result);
+}
+
+// 나누어떨어질 때만 정수로 남는다. 0으로 나누기와 -0은 double이 처리한다.
+static inline Value intDivide(int32_t a, int32_t b) {
+    // INT32_MIN % -1과 INT32_MIN / -1은 int32로 계산할 수 없다.
+    if (b == -1 && a != 0) return intResult(-(int64_t)a);
+    if (b == 0 || a % b != 0 || (a == 0 && b < 0)) {
+        return NUMBER_VAL((double)a / b);
+    }
+    return intResult((int64_t)a / b);
 }
 
 static InterpretResult run() {
 #define READ_BYTE() (*vm.ip++)
+#define READ_SHORT() \
+    (vm.ip += 2, (uint16_t)((vm.ip[-2] << 8) | vm.ip[-1]))
 #define READ_CONSTANT() (vm.chunk->constants.values[READ_BYTE()])
+#define READ_CACHE() (&vm.chunk->caches[READ_SHORT()])
 #define BINARY_OP(valueType, op) \
     do { \
         if (!IS_NUMBER(peek(0)) || !IS_NUMBER(peek(1))) { \
             runtimeError("Operands must be numbers."); \
+            return INTERPRET_RUNTIME_ERROR; \
         } \
         double b = AS_NUMBER(pop()); \
         double a = AS_NUMBER(pop()); \
         push(valueType(a op b)); \
     } while (false)
+// 두 피연산자가 모두 정수면 정수 연산을, 아니면 double 연산을 한다.
+// 어느 쪽을 탔는지 명령어의 캐시에 남긴다.
+#define INT_BINARY_OP(intOp, valueType, op) \
+    do { \
+        InlineCache* cache = READ_CACHE(); \
+        if (IS_INT(peek(0)) && IS_INT(peek(1))) { \
+            cache->types |= FEEDBACK_INT; \
+            int32_t b = AS_INT(pop()); \
+            int32_t a = AS_INT(pop()); \
+            push(intOp); \
+        } else { \
+            BINARY_OP(valueType, op); \
+            cache->types |= FEEDBACK_DOUBLE; \
+        } \
+    } while (false)
 
     for (;;) {
 #ifdef DEBUG_TRACE_EXECUTION
@@ -107,18 +236,73 @@ static InterpretResult run() {
             case OP_NIL: push(NIL_VAL); break;
             case OP_TRUE: push(BOOL_VAL(true)); break;
             case OP_FALSE: push(BOOL_VAL(false)); break;
+            case OP_POP: pop(); break;
+            case OP_GET_LOCAL: {
+                uint8_t slot = READ_BYTE();
+                push(vm.stack[slot]);
+                break;
+            }
+            case OP_SET_LOCAL: {
+                uint8_t slot = READ_BYTE();
+                vm.stack[slot] = peek(0);
+                break;
+            }
+            case OP_GET_GLOBAL: {
+                uint16_t slot = READ_SHORT();
+                Value value = vm.globalValues.values[slot];
+                if (IS_UNDEFINED(value)) {
+                    runtimeError("Undefined variable '%s'.",
+                        AS_CSTRING(vm.globalIdentifiers.values[slot]));
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                push(value);
+                break;
+            }
+            case OP_DEFINE_GLOBAL: {
+                uint16_t slot = READ_SHORT();
+                // 전역은 실행이 끝나도 남으므로 스크래치 문자열을 힙으로 옮긴다.
+                vm.globalValues.values[slot] = promoteValue(peek(0));
+                pop();
+                break;
+            }
+            case OP_SET_GLOBAL: {
+                uint16_t slot = READ_SHORT();
+                if (IS_UNDEFINED(vm.globalValues.values[slot])) {
+                    runtimeError("Undefined variable '%s'.",
+                        AS_CSTRING(vm.globalIdentifiers.values[slot]));
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                vm.globalValues.values[slot] = promoteValue(peek(0));
+                break;
+            }
             case OP_EQUAL: {
                 Value b = pop();
                 Value a = pop();
                 push(BOOL_VAL(valuesEqual(a, b)));
                 break;
             }
-            case OP_GREATER:    BINARY_OP(BOOL_VAL, >); break;
-            case OP_LESS:       BINARY_OP(BOOL_VAL, <); break;
+            case OP_GREATER:
+                INT_BINARY_OP(BOOL_VAL(a > b), BOOL_VAL, >);
+                break;
+            case OP_LESS:
+                INT_BINARY_OP(BOOL_VAL(a < b), BOOL_VAL, <);
+                break;
             case OP_ADD: {
-                if (IS_STRING(peek(0)) && IS_STRING(peek(1))) {
+                InlineCache* cache = READ_CACHE();
+                // 문자열만 본 덧셈은 숫자 검사를 건너뛴다.
+                if (cache->types == FEEDBACK_STRING &&
+                    IS_STRING(peek(0)) && IS_STRING(peek(1))) {
+                    concatenate();
+                } else if (IS_INT(peek(0)) && IS_INT(peek(1))) {
+                    cache->types |= FEEDBACK_INT;
+                    int32_t b = AS_INT(pop());
+                    int32_t a = AS_INT(pop());
+                    push(intResult((int64_t)a + b));
+                } else if (IS_STRING(peek(0)) && IS_STRING(peek(1))) {
+                    cache->types |= FEEDBACK_STRING;
                     concatenate();
                 } else if (IS_NUMBER(peek(0)) && IS_NUMBER(peek(1))) {
+                    cache->types |= FEEDBACK_DOUBLE;
                     double b = AS_NUMBER(pop());
                     double a = AS_NUMBER(pop());
                     push(NUMBER_VAL(a + b));
@@ -129,9 +313,15 @@ static InterpretResult run() {
                 }
                 break;
             }
-            case OP_SUBTRACT:   BINARY_OP(NUMBER_VAL, -); break;
-            case OP_MULTIPLY:   BINARY_OP(NUMBER_VAL, *); break;
-            case OP_DIVIDE:     BINARY_OP(NUMBER_VAL, /); break;
+            case OP_SUBTRACT:
+                INT_BINARY_OP(intResult((int64_t)a - b), NUMBER_VAL, -);
+                break;
+            case OP_MULTIPLY:
+                INT_BINARY_OP(intMultiply(a, b), NUMBER_VAL, *);
+                break;
+            case OP_DIVIDE:
+                INT_BINARY_OP(intDivide(a, b), NUMBER_VAL, /);
+                break;
             case OP_NOT:
                 push(BOOL_VAL(isFalsey(pop())));
                 break;
@@ -140,19 +330,81 @@ static InterpretResult run() {
                     runtimeError("Operand must be a number.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
+                if (IS_INT(peek(0))) {
+                    int32_t a = AS_INT(pop());
+                    // -0과 -INT32_MIN은 정수로 표현할 수 없다.
+                    push(a == 0 ? NUMBER_VAL(-0.0) : intResult(-(int64_t)a));
+                    break;
+                }
                 push(NUMBER_VAL(-AS_NUMBER(pop())));
                 break;
-            case OP_RETURN: {
+            case OP_CALL_NATIVE: {
+                Native* native = &vm.natives[READ_BYTE()];
+                int argCount = READ_BYTE();
+                // 인자를 복사하지 않고 스택 위치를 그대로 넘긴다.
+                Value* args = vm.stackTop - argCount;
+                Value result = native->function(argCount, args);
+                if (vm.nativeFailed) {
+                    vm.nativeFailed = false;
+                    runtimeError("%s", vm.nativeErrorMessage);
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+
+                vm.stackTop = args;
+                push(result);
+                break;
+            }
+            case OP_PRINT: {
                 printValue(pop());
                 printf("\n");
+                break;
+            }
+            case OP_RETURN: {
+                // 인터프리터를 종료한다.
                 return INTERPRET_OK;
             }
         }
     }
 
 #undef READ_BYTE
+#undef READ_SHORT
 #undef READ_CONSTANT
+#undef READ_CACHE
 #undef BINARY_OP
+#undef INT_BINARY_OP
+}
+
+// 컴파일된 청크를 실행한다. 청크는 읽기만 하므로 읽기 전용 메모리여도 된다.
+InterpretResult interpretChunk(Chunk* chunk) {
+    vm.chunk = chunk;
+    vm.ip = vm.chunk->code;
+
+    // push()는 검사하지 않는다. 청크가 쓸 스택을 실행 전에 한 번만 확인한다.
+    if (vm.stackTop - vm.stack + chunk->maxStack > STACK_MAX) {
+        fprintf(stderr, "Stack overflow.\n");
+        return INTERPRET_RUNTIME_ERROR;
+    }
+
+    vm.scratchActive = vm.scratchMode;
+    int scratchCapacity = vm.scratchStrings.capacity;
+    InterpretResult result = run();
+
+    // 스택에 남은 값도 버려지므로 스크래치 문자열은 더 이상 참조되지 않는다.
+    if (vm.scratchActive) {
+        vm.scratchActive = false;
+        resetStack();
+        // 이번 실행 중에 테이블이 커졌다면 넣은 키가 용량에 비례할 만큼
+        // 많았다는 뜻이므로 전체를 지워도 비용은 키 수에 비례한다.
+        if (vm.scratchStrings.capacity == scratchCapacity) {
+            tableClearKeys(&vm.scratchStrings, vm.scratchKeys,
+                           vm.scratchKeyCount);
+        } else {
+            tableClear(&vm.scratchStrings);
+        }
+        vm.scratchKeyCount = 0;
+        resetRegion(&vm.scratch);
+    }
+    return result;
 }
 
 InterpretResult interpret(const char* source) {
@@ -164,10 +416,7 @@ InterpretResult interpret(const char* source) {
         return INTERPRET_COMPILE_ERROR;
     }
 
-    vm.chunk = &chunk;
-    vm.ip = vm.chunk->code;
-
-    InterpretResult result = run();
+    InterpretResult result = interpretChunk(&chunk);
 
     freeChunk(&chunk);
     return result;
@@ -2,10 +2,24 @@
 #define clox_vm_h
 
 #include "chunk.h"
+#include "region.h"
+#include "strfilter.h"
 #include "table.h"
 #include "value.h"
 
-#define STACK_MAX 256
+// 지역 변수 UINT8_COUNT개와 그 위의 임시 값들이 들어갈 만큼 잡는다.
+#define STACK_MAX (UINT8_COUNT * 2)
+#define NATIVES_MAX (UINT8_MAX + 1)
+
+// 네이티브 함수 호출 규약. 인자는 VM 스택을 가리키는 포인터와 개수로 받고
+// 결과는 Value로 바로 돌려준다. 에러는 nativeError()로 알린다.
+typedef Value (*NativeFn)(int argCount, Value* args);
+
+typedef struct {
+    ObjString* name;
+    NativeFn function;
+    int arity; // -1이면 인자 개수를 네이티브가 직접 검사한다.
+} Native;
 
 typedef struct {
     Chunk* chunk;
@@ -13,7 +27,36 @@ typedef struct {
     Value stack[STACK_MAX];
     Value* stackTop;
     Table strings;
+    // enableStringFilter()로 켜는 vm.strings 앞의 블룸 필터
+    StringFilter stringFilter;
+    // 켜 두면 문자열을 만들 때마다 UTF-8을 검사해서 인코딩을 기록한다.
+    bool validateStrings;
+    // 전역 변수. 컴파일러가 이름마다 고정 인덱스를 정하고 VM은 배열로만 접근한다.
+    // 이름 테이블은 컴파일과 에러 메시지에만 쓴다.
+    Table globalNames;
+    ValueArray globalValues;
+    ValueArray globalIdentifiers;
     Obj* objects;
+    // 켜 두면 interpret()가 실행 중에 만드는 문자열을 스크래치 영역에 잡고
+    // 실행이 끝나면 영역을 통째로 되감는다. 전역이나 맵에 저장되어
+    // 살아남는 문자열은 그 시점에 힙으로 복사한다.
+    bool scratchMode;
+    bool scratchActive;
+    Region scratch;
+    Table scratchStrings;
+    // 이번 실행에서 scratchStrings에 넣은 키. 되감을 때 이 칸만 비운다.
+    ObjString** scratchKeys;
+    int scratchKeyCount;
+    int scratchKeyCapacity;
+    // loadSnapshot()이 매핑한 힙 이미지
+    void* image;
+    size_t imageSize;
+    // 네이티브는 컴파일 시점에 이름으로 찾아서 인덱스로 호출한다.
+    Native natives[NATIVES_MAX];
+    int nativeCount;
+    Table nativeNames;
+    bool nativeFailed;
+    char nativeErrorMessage[256];
 } VM;
 
 typedef enum {
@@ -27,7 +70,13 @@ extern VM vm;
 void initVM();
 void freeVM();
 InterpretResult interpret(const char* source);
+InterpretResult interpretChunk(Chunk* chunk);
 void push(Value value);
 Value pop();
+int globalSlotFor(ObjString* name);
+void defineGlobal(const char* name, Value value);
+void enableStringFilter();
+void defineNative(const char* name, int arity, NativeFn function);
+Value nativeError(const char* format, ...);
 
 #endif
\ No newline at end of file
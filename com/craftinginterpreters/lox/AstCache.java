@@ -0,0 +1,731 @@
+package com.craftinginterpreters.lox;
+
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.DataInputStream;
+import java.io.DataOutputStream;
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.FileSystems;
+import java.nio.file.Files;
+import java.nio.file.LinkOption;
+import java.nio.file.Path;
+import java.nio.file.Paths;
+import java.nio.file.StandardCopyOption;
+import java.nio.file.attribute.PosixFilePermission;
+import java.nio.file.attribute.PosixFilePermissions;
+import java.nio.file.attribute.UserPrincipal;
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
+import java.util.ArrayList;
+import java.util.EnumSet;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+
+// 리졸브까지 끝난 AST를 바이너리로 저장해 두고, 같은 소스를 다시 실행할 때
+// 스캐너, 파서, 리졸버를 건너뛴다. 파일 이름은 소스의 SHA-256 해시다.
+//
+// 형식: 매직, 버전, 문자열 테이블, 문장 리스트.
+// 노드는 태그 바이트 하나로 시작하고 0은 null이다. 정수는 가변 길이로 쓴다.
+// 리졸브 결과(거리, 인라인 블록, 프레임 없는 함수)는 해당 노드 바로 뒤에 붙는다.
+//
+// 해시는 소스를 가리킬 뿐 파일 내용을 보증하지 않는다. 그래서 캐시는
+// 사용자 전용 디렉터리($XDG_CACHE_HOME/jlox 또는 ~/.cache/jlox)에만 두고,
+// 다른 사용자가 만들었거나 쓸 수 있는 디렉터리면 쓰지 않는다.
+// -Djlox.astCache=false로 끌 수 있다.
+class AstCache {
+    private static final int MAGIC = 0x4C4F5841; // "LOXA"
+    private static final int VERSION = 2;
+
+    private static final TokenType[] tokenTypes = TokenType.values();
+
+    private static boolean checked = false;
+    private static Path cacheDirectory;
+    private static volatile boolean warned = false;
+
+    // 캐시가 없거나 깨져 있으면 null을 돌려준다.
+    // 캐시는 소스 내용으로만 찾으므로 파일 경로는 읽으면서 토큰에 붙인다.
+    static List<Stmt> load(String source, String sourcePath,
+                           Interpreter interpreter) {
+        Path path = pathFor(source);
+        if (path == null ||
+            !Files.isRegularFile(path, LinkOption.NOFOLLOW_LINKS)) {
+            return null;
+        }
+
+        try {
+            byte[] bytes = Files.readAllBytes(path);
+            Reader reader = new Reader(interpreter, sourcePath,
+                new DataInputStream(new ByteArrayInputStream(bytes)));
+            return reader.readProgram();
+        } catch (IOException | RuntimeException error) {
+            return null;
+        }
+    }
+
+    // 캐시는 최선을 다할 뿐이다. 쓰기에 실패해도 실행에는 영향이 없다.
+    static void store(String source, List<Stmt> statements,
+                      Interpreter interpreter) {
+        Path path = pathFor(source);
+        if (path == null) return;
+
+        try {
+            byte[] bytes = new Writer(interpreter).writeProgram(statements);
+            // 다른 프로세스가 반쯤 쓴 파일을 읽지 않도록 옮겨서 바꾼다.
+            Path temp = Files.createTempFile(path.getParent(), "ast", ".tmp");
+            Files.write(temp, bytes);
+            Files.move(temp, path, StandardCopyOption.REPLACE_EXISTING,
+                       StandardCopyOption.ATOMIC_MOVE);
+        } catch (IOException | RuntimeException error) {
+            warn("could not write " + path + ": " + error.getMessage());
+        }
+    }
+
+    // 실패할 때마다 알리면 시끄러우므로 처음 한 번만 알린다.
+    private static void warn(String message) {
+        if (warned) return;
+        warned = true;
+        System.err.println("Warning: AST cache " + message);
+    }
+
+    // 처음 부를 때 캐시 디렉터리를 만들고 검사한다. 쓸 수 없으면 null이다.
+    private static synchronized Path directory() {
+        if (checked) return cacheDirectory;
+        checked = true;
+        if (System.getProperty("jlox.astCache", "true").equals("false")) {
+            return null;
+        }
+
+        String base = System.getenv("XDG_CACHE_HOME");
+        Path path = base != null && !base.isEmpty()
+            ? Paths.get(base, "jlox")
+            : Paths.get(System.getProperty("user.home"), ".cache", "jlox");
+
+        try {
+            if (!Files.exists(path, LinkOption.NOFOLLOW_LINKS)) {
+                Files.createDirectories(path.getParent());
+                try {
+                    Files.createDirectory(path,
+                        PosixFilePermissions.asFileAttribute(
+                            EnumSet.of(PosixFilePermission.OWNER_READ,
+                                       PosixFilePermission.OWNER_WRITE,
+                                       PosixFilePermission.OWNER_EXECUTE)));
+                } catch (UnsupportedOperationException error) {
+                    // POSIX 권한이 없는 파일 시스템
+                    Files.createDirectory(path);
+                }
+            }
+
+            if (!isTrusted(path)) {
+                warn("disabled, " + path +
+                     " is not a private directory owned by you.");
+                return null;
+            }
+        } catch (IOException | RuntimeException error) {
+            warn("disabled, could not use " + path + ": " +
+                 error.getMessage());
+            return null;
+        }
+
+        cacheDirectory = path;
+        return cacheDirectory;
+    }
+
+    // 심볼릭 링크가 아닌 디렉터리이고, 주인이 현재 사용자이며, 그룹이나
+    // 다른 사용자가 접근할 수 없어야 한다.
+    private static boolean isTrusted(Path path) throws IOException {
+        if (!Files.isDirectory(path, LinkOption.NOFOLLOW_LINKS)) return false;
+
+        UserPrincipal owner = Files.getOwner(path, LinkOption.NOFOLLOW_LINKS);
+        UserPrincipal user = FileSystems.getDefault()
+            .getUserPrincipalLookupService()
+            .lookupPrincipalByName(System.getProperty("user.name"));
+        if (!owner.equals(user)) return false;
+
+        try {
+            Set<PosixFilePermission> permissions =
+                Files.getPosixFilePermissions(path, LinkOption.NOFOLLOW_LINKS);
+            return permissions.equals(EnumSet.of(
+                PosixFilePermission.OWNER_READ,
+                PosixFilePermission.OWNER_WRITE,
+                PosixFilePermission.OWNER_EXECUTE));
+        } catch (UnsupportedOperationException error) {
+            return true;
+        }
+    }
+
+    private static Path pathFor(String source) {
+        Path directory = directory();
+        if (directory == null) return null;
+
+        try {
+            MessageDigest digest = MessageDigest.getInstance("SHA-256");
+            byte[] hash = digest.digest(
+                source.getBytes(StandardCharsets.UTF_8));
+
+            StringBuilder name = new StringBuilder();
+            for (byte b : hash) {
+                name.append(String.format("%02x", b));
+            }
+            name.append(".ast");
+            return directory.resolve(name.toString());
+        } catch (NoSuchAlgorithmException error) {
+            return null;
+        }
+    }
+
+    // 태그 값
+    private static final int NULL = 0;
+
+    private static final int STMT_BLOCK = 1;
+    private static final int STMT_CLASS = 2;
+    private static final int STMT_EXPRESSION = 3;
+    private static final int STMT_FUNCTION = 4;
+    private static final int STMT_IF = 5;
+    private static final int STMT_PRINT = 6;
+    private static final int STMT_RETURN = 7;
+    private static final int STMT_VAR = 8;
+    private static final int STMT_WHILE = 9;
+
+    private static final int EXPR_ASSIGN = 1;
+    private static final int EXPR_BINARY = 2;
+    private static final int EXPR_CALL = 3;
+    private static final int EXPR_GET = 4;
+    private static final int EXPR_GROUPING = 5;
+    private static final int EXPR_LITERAL = 6;
+    private static final int EXPR_LOGICAL = 7;
+    private static final int EXPR_SET = 8;
+    private static final int EXPR_SUPER = 9;
+    private static final int EXPR_THIS = 10;
+    private static final int EXPR_UNARY = 11;
+    private static final int EXPR_VARIABLE = 12;
+
+    private static final int VALUE_TRUE = 1;
+    private static final int VALUE_FALSE = 2;
+    private static final int VALUE_NUMBER = 3;
+    private static final int VALUE_STRING = 4;
+
+    private static class Writer implements Expr.Visitor<Void>,
+                                           Stmt.Visitor<Void> {
+        private final Interpreter interpreter;
+        // 렉심은 반복이 많으므로 테이블에 한 번만 넣고 인덱스로 가리킨다.
+        private final Map<String, Integer> strings = new HashMap<>();
+        private final List<String> stringList = new ArrayList<>();
+        private final ByteArrayOutputStream body =
+            new ByteArrayOutputStream();
+        private final DataOutputStream out = new DataOutputStream(body);
+
+        Writer(Interpreter interpreter) {
+            this.interpreter = interpreter;
+        }
+
+        byte[] writeProgram(List<Stmt> statements) throws IOException {
+            writeStmts(statements);
+            out.flush();
+
+            ByteArrayOutputStream file = new ByteArrayOutputStream();
+            DataOutputStream header = new DataOutputStream(file);
+            header.writeInt(MAGIC);
+            header.writeInt(VERSION);
+            writeVarint(header, stringList.size());
+            // writeUTF는 64KB가 넘는 문자열을 받지 않으므로 길이를 직접 쓴다.
+            for (String string : stringList) {
+                byte[] bytes = string.getBytes(StandardCharsets.UTF_8);
+                writeVarint(header, bytes.length);
+                header.write(bytes);
+            }
+            header.flush();
+            body.writeTo(file);
+            return file.toByteArray();
+        }
+
+        private void writeStmts(List<? extends Stmt> statements) {
+            writeInt(statements.size());
+            for (Stmt statement : statements) {
+                writeStmt(statement);
+            }
+        }
+
+        private void writeStmt(Stmt stmt) {
+            if (stmt == null) {
+                writeByte(NULL);
+            } else {
+                stmt.accept(this);
+            }
+        }
+
+        private void writeExpr(Expr expr) {
+            if (expr == null) {
+                writeByte(NULL);
+            } else {
+                expr.accept(this);
+            }
+        }
+
+        // 리졸브되지 않은(전역) 참조는 0, 나머지는 거리 + 1
+        private void writeDepth(Expr expr) {
+            Integer depth = interpreter.depth(expr);
+            writeInt(depth == null ? 0 : depth + 1);
+        }
+
+        private void writeToken(Token token) {
+            writeByte(token.type.ordinal());
+            writeString(token.lexeme);
+            writeValue(token.literal);
+            writeInt(token.line);
+        }
+
+        private void writeTokens(List<Token> tokens) {
+            writeInt(tokens.size());
+            for (Token token : tokens) {
+                writeToken(token);
+            }
+        }
+
+        private void writeValue(Object value) {
+            if (value == null) {
+                writeByte(NULL);
+            } else if (value instanceof Boolean) {
+                writeByte((Boolean)value ? VALUE_TRUE : VALUE_FALSE);
+            } else if (value instanceof Double) {
+                writeByte(VALUE_NUMBER);
+                try {
+                    out.writeDouble((Double)value);
+                } catch (IOException error) {
+                    throw new IllegalStateException(error);
+                }
+            } else {
+                writeByte(VALUE_STRING);
+                writeString((String)value);
+            }
+        }
+
+        private void writeString(String string) {
+            Integer index = strings.get(string);
+            if (index == null) {
+                index = stringList.size();
+                strings.put(string, index);
+                stringList.add(string);
+            }
+            writeInt(index);
+        }
+
+        private void writeByte(int value) {
+            try {
+                out.writeByte(value);
+            } catch (IOException error) {
+                throw new IllegalStateException(error);
+            }
+        }
+
+        private void writeInt(int value) {
+            try {
+                writeVarint(out, value);
+            } catch (IOException error) {
+                throw new IllegalStateException(error);
+            }
+        }
+
+        private void writeFunction(Stmt.Function function) {
+            writeToken(function.name);
+            writeTokens(function.params);
+            writeStmts(function.body);
+            writeByte(interpreter.needsFrame(function) ? 0 : 1);
+        }
+
+        @Override
+        public Void visitBlockStmt(Stmt.Block stmt) {
+            writeByte(STMT_BLOCK);
+            writeStmts(stmt.statements);
+            writeByte(interpreter.isInline(stmt) ? 1 : 0);
+            return null;
+        }
+
+        @Override
+        public Void visitClassStmt(Stmt.Class stmt) {
+            writeByte(STMT_CLASS);
+            writeToken(stmt.name);
+            writeExpr(stmt.superclass);
+            writeInt(stmt.methods.size());
+            for (Stmt.Function method : stmt.methods) {
+                writeFunction(method);
+            }
+            return null;
+        }
+
+        @Override
+        public Void visitExpressionStmt(Stmt.Expression stmt) {
+            writeByte(STMT_EXPRESSION);
+            writeExpr(stmt.expression);
+            return null;
+        }
+
+        @Override
+        public Void visitFunctionStmt(Stmt.Function stmt) {
+            writeByte(STMT_FUNCTION);
+            writeFunction(stmt);
+            return null;
+        }
+
+        @Override
+        public Void visitIfStmt(Stmt.If stmt) {
+            writeByte(STMT_IF);
+            writeExpr(stmt.condition);
+            writeStmt(stmt.thenBranch);
+            writeStmt(stmt.elseBranch);
+            return null;
+        }
+
+        @Override
+        public Void visitPrintStmt(Stmt.Print stmt) {
+            writeByte(STMT_PRINT);
+            writeExpr(stmt.expression);
+            return null;
+        }
+
+        @Override
+        public Void visitReturnStmt(Stmt.Return stmt) {
+            writeByte(STMT_RETURN);
+            writeToken(stmt.keyword);
+            writeExpr(stmt.value);
+            return null;
+        }
+
+        @Override
+        public Void visitVarStmt(Stmt.Var stmt) {
+            writeByte(STMT_VAR);
+            writeToken(stmt.name);
+            writeExpr(stmt.initializer);
+            return null;
+        }
+
+        @Override
+        public Void visitWhileStmt(Stmt.While stmt) {
+            writeByte(STMT_WHILE);
+            writeExpr(stmt.condition);
+            writeStmt(stmt.body);
+            return null;
+        }
+
+        @Override
+        public Void visitAssignExpr(Expr.Assign expr) {
+            writeByte(EXPR_ASSIGN);
+            writeToken(expr.name);
+            writeExpr(expr.value);
+            writeDepth(expr);
+            return null;
+        }
+
+        @Override
+        public Void visitBinaryExpr(Expr.Binary expr) {
+            writeByte(EXPR_BINARY);
+            writeExpr(expr.left);
+            writeToken(expr.operator);
+            writeExpr(expr.right);
+            return null;
+        }
+
+        @Override
+        public Void visitCallExpr(Expr.Call expr) {
+            writeByte(EXPR_CALL);
+            writeExpr(expr.callee);
+            writeToken(expr.paren);
+            writeInt(expr.arguments.size());
+            for (Expr argument : expr.arguments) {
+                writeExpr(argument);
+            }
+            return null;
+        }
+
+        @Override
+        public Void visitGetExpr(Expr.Get expr) {
+            writeByte(EXPR_GET);
+            writeExpr(expr.object);
+            writeToken(expr.name);
+            return null;
+        }
+
+        @Override
+        public Void visitGroupingExpr(Expr.Grouping expr) {
+            writeByte(EXPR_GROUPING);
+            writeExpr(expr.expression);
+            return null;
+        }
+
+        @Override
+        public Void visitLiteralExpr(Expr.Literal expr) {
+            writeByte(EXPR_LITERAL);
+            writeValue(expr.value);
+            return null;
+        }
+
+        @Override
+        public Void visitLogicalExpr(Expr.Logical expr) {
+            writeByte(EXPR_LOGICAL);
+            writeExpr(expr.left);
+            writeToken(expr.operator);
+            writeExpr(expr.right);
+            return null;
+        }
+
+        @Override
+        public Void visitSetExpr(Expr.Set expr) {
+            writeByte(EXPR_SET);
+            writeExpr(expr.object);
+            writeToken(expr.name);
+            writeExpr(expr.value);
+            return null;
+        }
+
+        @Override
+        public Void visitSuperExpr(Expr.Super expr) {
+            writeByte(EXPR_SUPER);
+            writeToken(expr.keyword);
+            writeToken(expr.method);
+            writeDepth(expr);
+            return null;
+        }
+
+        @Override
+        public Void visitThisExpr(Expr.This expr) {
+            writeByte(EXPR_THIS);
+            writeToken(expr.keyword);
+            writeDepth(expr);
+            return null;
+        }
+
+        @Override
+        public Void visitUnaryExpr(Expr.Unary expr) {
+            writeByte(EXPR_UNARY);
+            writeToken(expr.operator);
+            writeExpr(expr.right);
+            return null;
+        }
+
+        @Override
+        public Void visitVariableExpr(Expr.Variable expr) {
+            writeByte(EXPR_VARIABLE);
+            writeToken(expr.name);
+            writeDepth(expr);
+            return null;
+        }
+    }
+
+    private static class Reader {
+        private final Interpreter interpreter;
+        private final String sourcePath;
+        private final DataInputStream in;
+        private String[] strings;
+
+        Reader(Interpreter interpreter, String sourcePath,
+               DataInputStream in) {
+            this.interpreter = interpreter;
+            this.sourcePath = sourcePath;
+            this.in = in;
+        }
+
+        List<Stmt> readProgram() throws IOException {
+            if (in.readInt() != MAGIC || in.readInt() != VERSION) {
+                return null;
+            }
+
+            strings = new String[readVarint(in)];
+            for (int i = 0; i < strings.length; i++) {
+                int length = readVarint(in);
+                if (length > in.available()) {
+                    throw new IOException("Truncated string table.");
+                }
+                byte[] bytes = new byte[length];
+                in.readFully(bytes);
+                strings[i] = new String(bytes, StandardCharsets.UTF_8);
+            }
+
+            return readStmts();
+        }
+
+        private List<Stmt> readStmts() throws IOException {
+            int count = readVarint(in);
+            List<Stmt> statements = new ArrayList<>(count);
+            for (int i = 0; i < count; i++) {
+                statements.add(readStmt());
+            }
+            return statements;
+        }
+
+        private Stmt readStmt() throws IOException {
+            int tag = in.readUnsignedByte();
+            switch (tag) {
+                case NULL: return null;
+                case STMT_BLOCK: {
+                    Stmt.Block block = new Stmt.Block(readStmts());
+                    if (in.readUnsignedByte() != 0) interpreter.inline(block);
+                    return block;
+                }
+                case STMT_CLASS: {
+                    Token name = readToken();
+                    Expr.Variable superclass = (Expr.Variable)readExpr();
+                    int count = readVarint(in);
+                    List<Stmt.Function> methods = new ArrayList<>(count);
+                    for (int i = 0; i < count; i++) {
+                        methods.add(readFunction());
+                    }
+                    return new Stmt.Class(name, superclass, methods);
+                }
+                case STMT_EXPRESSION:
+                    return new Stmt.Expression(readExpr());
+                case STMT_FUNCTION:
+                    return readFunction();
+                case STMT_IF: {
+                    Expr condition = readExpr();
+                    Stmt thenBranch = readStmt();
+                    Stmt elseBranch = readStmt();
+                    return new Stmt.If(condition, thenBranch, elseBranch);
+                }
+                case STMT_PRINT:
+                    return new Stmt.Print(readExpr());
+                case STMT_RETURN: {
+                    Token keyword = readToken();
+                    return new Stmt.Return(keyword, readExpr());
+                }
+                case STMT_VAR: {
+                    Token name = readToken();
+                    return new Stmt.Var(name, readExpr());
+                }
+                case STMT_WHILE: {
+                    Expr condition = readExpr();
+                    return new Stmt.While(condition, readStmt());
+                }
+            }
+
+            throw new IOException("Bad statement tag " + tag + ".");
+        }
+
+        private Stmt.Function readFunction() throws IOException {
+            Token name = readToken();
+            List<Token> params = readTokens();
+            List<Stmt> body = readStmts();
+            Stmt.Function function = new Stmt.Function(name, params, body);
+            if (in.readUnsignedByte() != 0) interpreter.inline(function);
+            return function;
+        }
+
+        private Expr readExpr() throws IOException {
+            int tag = in.readUnsignedByte();
+            switch (tag) {
+                case NULL: return null;
+                case EXPR_ASSIGN: {
+                    Token name = readToken();
+                    Expr value = readExpr();
+                    return readDepth(new Expr.Assign(name, value));
+                }
+                case EXPR_BINARY: {
+                    Expr left = readExpr();
+                    Token operator = readToken();
+                    return new Expr.Binary(left, operator, readExpr());
+                }
+                case EXPR_CALL: {
+                    Expr callee = readExpr();
+                    Token paren = readToken();
+                    int count = readVarint(in);
+                    List<Expr> arguments = new ArrayList<>(count);
+                    for (int i = 0; i < count; i++) {
+                        arguments.add(readExpr());
+                    }
+                    return new Expr.Call(callee, paren, arguments);
+                }
+                case EXPR_GET: {
+                    Expr object = readExpr();
+                    return new Expr.Get(object, readToken());
+                }
+                case EXPR_GROUPING:
+                    return new Expr.Grouping(readExpr());
+                case EXPR_LITERAL:
+                    return new Expr.Literal(readValue());
+                case EXPR_LOGICAL: {
+                    Expr left = readExpr();
+                    Token operator = readToken();
+                    return new Expr.Logical(left, operator, readExpr());
+                }
+                case EXPR_SET: {
+                    Expr object = readExpr();
+                    Token name = readToken();
+                    return new Expr.Set(object, name, readExpr());
+                }
+                case EXPR_SUPER: {
+                    Token keyword = readToken();
+                    Token method = readToken();
+                    return readDepth(new Expr.Super(keyword, method));
+                }
+                case EXPR_THIS:
+                    return readDepth(new Expr.This(readToken()));
+                case EXPR_UNARY: {
+                    Token operator = readToken();
+                    return new Expr.Unary(operator, readExpr());
+                }
+                case EXPR_VARIABLE:
+                    return readDepth(new Expr.Variable(readToken()));
+            }
+
+            throw new IOException("Bad expression tag " + tag + ".");
+        }
+
+        private Expr readDepth(Expr expr) throws IOException {
+            int depth = readVarint(in);
+            if (depth != 0) interpreter.resolve(expr, depth - 1);
+            return expr;
+        }
+
+        private Token readToken() throws IOException {
+            TokenType type = tokenTypes[in.readUnsignedByte()];
+            String lexeme = strings[readVarint(in)];
+            Object literal = readValue();
+            int line = readVarint(in);
+            return new Token(type, lexeme, literal, line, sourcePath);
+        }
+
+        private List<Token> readTokens() throws IOException {
+            int count = readVarint(in);
+            List<Token> tokens = new ArrayList<>(count);
+            for (int i = 0; i < count; i++) {
+                tokens.add(readToken());
+            }
+            return tokens;
+        }
+
+        private Object readValue() throws IOException {
+            int tag = in.readUnsignedByte();
+            switch (tag) {
+                case NULL: return null;
+                case VALUE_TRUE: return true;
+                case VALUE_FALSE: return false;
+                case VALUE_NUMBER: return in.readDouble();
+                case VALUE_STRING: return strings[readVarint(in)];
+            }
+
+            throw new IOException("Bad value tag " + tag + ".");
+        }
+    }
+
+    // 7비트씩 끊어 쓰는 부호 없는 가변 길이 정수
+    private static void writeVarint(DataOutputStream out, int value)
+        throws IOException {
+        while ((value & ~0x7F) != 0) {
+            out.writeByte((value & 0x7F) | 0x80);
+            value >>>= 7;
+        }
+        out.writeByte(value);
+    }
+
+    private static int readVarint(DataInputStream in) throws IOException {
+        int value = 0;
+        for (int shift = 0; shift < 32; shift += 7) {
+            int b = in.readUnsignedByte();
+            value |= (b & 0x7F) << shift;
+            if ((b & 0x80) == 0) return value;
+        }
+
+        throw new IOException("Malformed varint.");
+    }
+}
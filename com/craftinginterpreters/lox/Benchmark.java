@@ -0,0 +1,330 @@
+package com.craftinginterpreters.lox;
+
+import java.io.BufferedReader;
+import java.io.File;
+import java.io.IOException;
+import java.io.InputStreamReader;
+import java.lang.management.ManagementFactory;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+
+// 외부 의존성 없는 jlox 내부 마이크로벤치마크.
+//
+// 사용법: Benchmark [--forks N] [--warmup N] [--iterations N]
+//                   [--time ms] [이름 필터]
+//
+// 측정마다 새 JVM을 띄워(fork) JIT 상태를 분리하고, 워밍업 반복 뒤의
+// 측정 반복에서 연산당 시간과 ThreadMXBean으로 잰 연산당 할당량을 모은다.
+public class Benchmark {
+    private interface Workload {
+        Object run();
+    }
+
+    // 준비 작업을 한 뒤 측정할 워크로드를 돌려준다.
+    private interface Setup {
+        Workload prepare();
+    }
+
+    // 스캐너, 파서, 리졸버 측정용 소스. 클래스, 클로저, 반복문이 골고루 섞여 있다.
+    private static final String SOURCE = buildSource(200);
+
+    private static String buildSource(int copies) {
+        StringBuilder source = new StringBuilder();
+        for (int i = 0; i < copies; i++) {
+            source.append("class Shape").append(i).append(" {\n")
+                  .append("  init(w, h) { this.w = w; this.h = h; }\n")
+                  .append("  area() { return this.w * this.h; }\n")
+                  .append("}\n")
+                  .append("fun counter").append(i).append("() {\n")
+                  .append("  var count = 0;\n")
+                  .append("  fun next() { count = count + 1; return count; }\n")
+                  .append("  return next;\n")
+                  .append("}\n")
+                  .append("var total").append(i).append(" = 0;\n")
+                  .append("for (var j = 0; j < 10; j = j + 1) {\n")
+                  .append("  if (j > 5 and j != 7) { total").append(i)
+                  .append(" = total").append(i).append(" + j; }\n")
+                  .append("  else { print \"skip\" + \"ped\"; }\n")
+                  .append("}\n");
+        }
+        return source.toString();
+    }
+
+    private static final Map<String, Setup> cases = new LinkedHashMap<>();
+
+    static {
+        cases.put("scanner.scanTokens",
+            () -> () -> new Scanner(SOURCE).scanTokens());
+
+        cases.put("parser.parse", () -> {
+            List<Token> tokens = new Scanner(SOURCE).scanTokens();
+            return () -> new Parser(tokens).parse();
+        });
+
+        cases.put("resolver.resolve", () -> {
+            List<Stmt> statements = parse(SOURCE);
+            Interpreter interpreter = new Interpreter();
+            return () -> {
+                new Resolver(interpreter).resolve(statements);
+                return interpreter;
+            };
+        });
+
+        cases.put("environment.get", () -> {
+            // 전역까지 다섯 단계를 거슬러 올라가는 이름 조회
+            Environment environment = new Environment();
+            environment.define("x", 1.0);
+            for (int i = 0; i < 5; i++) {
+                environment = new Environment(environment);
+                environment.define("y" + i, 1.0);
+            }
+            Environment innermost = environment;
+            Token name = new Token(TokenType.IDENTIFIER, "x", null, 1);
+            return () -> innermost.get(name);
+        });
+
+        cases.put("environment.getAt", () -> {
+            Environment environment = new Environment();
+            environment.define("x", 1.0);
+            for (int i = 0; i < 5; i++) {
+                environment = new Environment(environment);
+            }
+            Environment innermost = environment;
+            return () -> innermost.getAt(5, "x");
+        });
+
+        cases.put("instance.getField", () -> {
+            Interpreter interpreter = prepare(
+                "class Point { init() { this.x = 1; } }");
+            LoxInstance instance = (LoxInstance)((LoxClass)
+                global(interpreter, "Point")).call(interpreter,
+                                                   new ArrayList<>());
+            Token name = new Token(TokenType.IDENTIFIER, "x", null, 1);
+            return () -> instance.get(name);
+        });
+
+        cases.put("instance.getMethod", () -> {
+            Interpreter interpreter = prepare(
+                "class Point { norm() { return 0; } }");
+            LoxInstance instance = (LoxInstance)((LoxClass)
+                global(interpreter, "Point")).call(interpreter,
+                                                   new ArrayList<>());
+            Token name = new Token(TokenType.IDENTIFIER, "norm", null, 1);
+            return () -> instance.get(name);
+        });
+
+        cases.put("interpreter.call", () -> {
+            Interpreter interpreter = prepare(
+                "fun id(a) { return a; }");
+            List<Stmt> call = resolved(interpreter, "id(1);");
+            return () -> {
+                interpreter.interpret(call);
+                return interpreter;
+            };
+        });
+
+        cases.put("interpreter.loop", () -> {
+            Interpreter interpreter = new Interpreter();
+            List<Stmt> loop = resolved(interpreter,
+                "var sum = 0;" +
+                "for (var i = 0; i < 100; i = i + 1) { sum = sum + i; }");
+            return () -> {
+                interpreter.interpret(loop);
+                return interpreter;
+            };
+        });
+    }
+
+    private static int forks = 2;
+    private static int warmupIterations = 5;
+    private static int measureIterations = 5;
+    private static long iterationMillis = 200;
+
+    // 결과가 버려지지 않도록 모아 두는 곳
+    private static volatile int sink;
+
+    public static void main(String[] args) throws Exception {
+        String filter = "";
+        boolean child = false;
+
+        for (int i = 0; i < args.length; i++) {
+            switch (args[i]) {
+                case "--forks": forks = Integer.parseInt(args[++i]); break;
+                case "--warmup":
+                    warmupIterations = Integer.parseInt(args[++i]);
+                    break;
+                case "--iterations":
+                    measureIterations = Integer.parseInt(args[++i]);
+                    break;
+                case "--time":
+                    iterationMillis = Long.parseLong(args[++i]);
+                    break;
+                case "--child": child = true; break;
+                default: filter = args[i]; break;
+            }
+        }
+
+        if (child) {
+            // 자식 JVM은 정확히 한 케이스만 돌리고 결과 줄을 출력한다.
+            runInProcess(filter);
+            return;
+        }
+
+        System.out.printf("%-22s %14s %14s %14s%n",
+            "benchmark", "ns/op", "error", "bytes/op");
+        for (String name : cases.keySet()) {
+            if (!name.contains(filter)) continue;
+
+            List<double[]> samples = new ArrayList<>();
+            if (forks == 0) {
+                samples.addAll(measure(name));
+            } else {
+                for (int fork = 0; fork < forks; fork++) {
+                    samples.addAll(fork(name));
+                }
+            }
+
+            report(name, samples);
+        }
+    }
+
+    private static void runInProcess(String name) {
+        for (double[] sample : measure(name)) {
+            System.out.println("RESULT " + sample[0] + " " + sample[1]);
+        }
+    }
+
+    private static List<double[]> fork(String name)
+        throws IOException, InterruptedException {
+        String java = System.getProperty("java.home") + File.separator +
+            "bin" + File.separator + "java";
+        List<String> command = new ArrayList<>(Arrays.asList(
+            java, "-cp", System.getProperty("java.class.path"),
+            Benchmark.class.getName(), "--child",
+            "--warmup", String.valueOf(warmupIterations),
+            "--iterations", String.valueOf(measureIterations),
+            "--time", String.valueOf(iterationMillis),
+            name));
+
+        Process process = new ProcessBuilder(command)
+            .redirectError(ProcessBuilder.Redirect.INHERIT)
+            .start();
+
+        // 워크로드의 print 출력은 무시하고 결과 줄만 읽는다.
+        List<double[]> samples = new ArrayList<>();
+        try (BufferedReader reader = new BufferedReader(
+                 new InputStreamReader(process.getInputStream()))) {
+            String line;
+            while ((line = reader.readLine()) != null) {
+                if (!line.startsWith("RESULT ")) continue;
+                String[] parts = line.split(" ");
+                samples.add(new double[] {
+                    Double.parseDouble(parts[1]),
+                    Double.parseDouble(parts[2])
+                });
+            }
+        }
+
+        if (process.waitFor() != 0) {
+            throw new IOException("Fork for " + name + " failed.");
+        }
+        return samples;
+    }
+
+    // 측정 반복마다 {연산당 나노초, 연산당 할당 바이트}를 돌려준다.
+    private static List<double[]> measure(String name) {
+        Workload workload = cases.get(name).prepare();
+        com.sun.management.ThreadMXBean threads =
+            (com.sun.management.ThreadMXBean)
+                ManagementFactory.getThreadMXBean();
+        boolean countAllocations = threads.isThreadAllocatedMemorySupported();
+        if (countAllocations) threads.setThreadAllocatedMemoryEnabled(true);
+        long threadId = Thread.currentThread().getId();
+
+        for (int i = 0; i < warmupIterations; i++) {
+            iteration(workload);
+        }
+
+        List<double[]> samples = new ArrayList<>();
+        for (int i = 0; i < measureIterations; i++) {
+            long bytesBefore = countAllocations
+                ? threads.getThreadAllocatedBytes(threadId) : 0;
+            long[] result = iteration(workload);
+            long bytes = countAllocations
+                ? threads.getThreadAllocatedBytes(threadId) - bytesBefore
+                : 0;
+
+            samples.add(new double[] {
+                (double)result[0] / result[1],
+                countAllocations ? (double)bytes / result[1] : Double.NaN
+            });
+        }
+        return samples;
+    }
+
+    // 정해진 시간 동안 워크로드를 반복한다. {경과 나노초, 연산 수}를 돌려준다.
+    private static long[] iteration(Workload workload) {
+        long deadline = System.nanoTime() + iterationMillis * 1_000_000;
+        long operations = 0;
+        int hash = 0;
+        long start = System.nanoTime();
+        long now;
+        do {
+            // 시계 호출 비용이 묻히도록 조금씩 묶어서 돌린다.
+            for (int i = 0; i < 16; i++) {
+                hash += System.identityHashCode(workload.run());
+            }
+            operations += 16;
+            now = System.nanoTime();
+        } while (now < deadline);
+
+        sink += hash;
+        return new long[] { now - start, operations };
+    }
+
+    private static void report(String name, List<double[]> samples) {
+        double mean = 0;
+        double bytes = 0;
+        for (double[] sample : samples) {
+            mean += sample[0];
+            bytes += sample[1];
+        }
+        mean /= samples.size();
+        bytes /= samples.size();
+
+        double variance = 0;
+        for (double[] sample : samples) {
+            variance += (sample[0] - mean) * (sample[0] - mean);
+        }
+        double error = samples.size() > 1
+            ? Math.sqrt(variance / (samples.size() - 1)) : 0;
+
+        System.out.printf("%-22s %14.1f %14.1f %14.1f%n",
+            name, mean, error, bytes);
+    }
+
+    private static List<Stmt> parse(String source) {
+        return new Parser(new Scanner(source).scanTokens()).parse();
+    }
+
+    private static List<Stmt> resolved(Interpreter interpreter,
+                                       String source) {
+        List<Stmt> statements = parse(source);
+        new Resolver(interpreter).resolve(statements);
+        return statements;
+    }
+
+    private static Interpreter prepare(String source) {
+        Interpreter interpreter = new Interpreter();
+        interpreter.interpret(resolved(interpreter, source));
+        return interpreter;
+    }
+
+    private static Object global(Interpreter interpreter, String name) {
+        return interpreter.globals.get(
+            new Token(TokenType.IDENTIFIER, name, null, 1));
+    }
+}
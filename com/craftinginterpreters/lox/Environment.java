@@ -2,23 +2,29 @@ package com.craftinginterpreters.lox;
 
 import java.util.HashMap;
 import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
 
 class Environment {
+    // ConcurrentHashMap은 null을 담지 못하므로 nil은 이 객체로 저장한다.
+    private static final Object NIL = new Object();
+
     final Environment enclosing;
-    private final Map<String, Object> values = new HashMap<>();
+    private Map<String, Object> values;
 
     Environment() {
+        // 전역 환경은 모든 스레드가 같이 쓴다.
         enclosing = null;
+        values = new ConcurrentHashMap<>();
     }
 
     Environment(Environment enclosing) {
         this.enclosing = enclosing;
+        values = new HashMap<>();
     }
 
     Object get(Token name) {
-        if (values.containsKey(name.lexeme)) {
-            return values.get(name.lexeme);
-        }
+        Object value = values.get(name.lexeme);
+        if (value != null) return unwrap(value);
 
         if (enclosing != null) return enclosing.get(name);
 
@@ -27,10 +33,7 @@ class Environment {
     }
 
     void assign(Token name, Object value) {
-        if (values.containsKey(name.lexeme)) {
-            values.put(name.lexeme, value);
-            return;
-        }
+        if (values.replace(name.lexeme, wrap(value)) != null) return;
 
         if (enclosing != null) {
             enclosing.assign(name, value);
@@ -42,7 +45,18 @@ class Environment {
     }
 
     void define(String name, Object value) {
-        values.put(name, value);
+        values.put(name, wrap(value));
+    }
+
+    // 다른 스레드에 넘기기 전에 호출한다.
+    // 체인 전체를 ConcurrentHashMap으로 바꿔서 동시에 읽고 써도 깨지지 않게 한다.
+    void share() {
+        for (Environment environment = this;
+             environment != null &&
+             !(environment.values instanceof ConcurrentHashMap);
+             environment = environment.enclosing) {
+            environment.values = new ConcurrentHashMap<>(environment.values);
+        }
     }
 
     Environment ancestor(int distance) {
@@ -55,10 +69,18 @@ class Environment {
     }
 
     Object getAt(int distance, String name) {
-        return ancestor(distance).values.get(name);
+        return unwrap(ancestor(distance).values.get(name));
     }
 
     void assignAt(int distance, Token name, Object value) {
-        ancestor(distance).values.put(name.lexeme, value);
+        ancestor(distance).values.put(name.lexeme, wrap(value));
+    }
+
+    private static Object wrap(Object value) {
+        return value == null ? NIL : value;
+    }
+
+    private static Object unwrap(Object value) {
+        return value == NIL ? null : value;
     }
 }
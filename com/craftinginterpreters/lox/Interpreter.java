@@ -4,14 +4,27 @@ import java.util.ArrayList;
 import java.util.HashMap;
 import java.util.List;
 import java.util.Map;
+import java.util.Set;
+import java.util.concurrent.ConcurrentHashMap;
 
 class Interpreter implements Expr.Visitor<Object>,
                              Stmt.Visitor<Void> {
-    final Environment globals = new Environment();
-    private Environment environment = globals;
-    private final Map<Expr, Integer> locals = new HashMap<>();
+    final Environment globals;
+    // 스레드마다 따로 갖는 유일한 상태
+    private Environment environment;
+    // 리졸버 결과는 spawn된 스레드들과 같이 읽으므로 동시성 컬렉션을 쓴다.
+    private final Map<Expr, Integer> locals;
+    // 리졸버가 자기 Environment 없이 실행해도 된다고 판단한 블록과 함수
+    private final Set<Stmt.Block> inlineBlocks;
+    private final Set<Stmt.Function> framelessFunctions;
 
     Interpreter() {
+        globals = new Environment();
+        environment = globals;
+        locals = new ConcurrentHashMap<>();
+        inlineBlocks = ConcurrentHashMap.newKeySet();
+        framelessFunctions = ConcurrentHashMap.newKeySet();
+
         globals.define("clock", new LoxCallable() {
             @Override
             public int arity() { return 0; }
@@ -25,6 +38,56 @@ class Interpreter implements Expr.Visitor<Object>,
             @Override
             public String toString() { return "<native fn>"; }
         }); 
+
+        globals.define("spawn", new LoxCallable() {
+            @Override
+            public int arity() { return 1; }
+
+            @Override
+            public Object call(Interpreter interpreter,
+                                List<Object> arguments) {
+                Object callee = arguments.get(0);
+                if (!(callee instanceof LoxFunction) ||
+                    ((LoxFunction)callee).arity() != 0) {
+                    throw new RuntimeError(null,
+                        "Can only spawn functions with no parameters.");
+                }
+
+                return new LoxTask(interpreter, (LoxFunction)callee);
+            }
+
+            @Override
+            public String toString() { return "<native fn>"; }
+        });
+
+        globals.define("join", new LoxCallable() {
+            @Override
+            public int arity() { return 1; }
+
+            @Override
+            public Object call(Interpreter interpreter,
+                                List<Object> arguments) {
+                Object task = arguments.get(0);
+                if (!(task instanceof LoxTask)) {
+                    throw new RuntimeError(null,
+                        "Can only join a spawned task.");
+                }
+
+                return ((LoxTask)task).join();
+            }
+
+            @Override
+            public String toString() { return "<native fn>"; }
+        });
+    }
+
+    // spawn된 스레드용 인터프리터. 전역과 리졸버 결과는 부모와 공유한다.
+    Interpreter(Interpreter parent) {
+        globals = parent.globals;
+        environment = globals;
+        locals = parent.locals;
+        inlineBlocks = parent.inlineBlocks;
+        framelessFunctions = parent.framelessFunctions;
     }
 
     void interpret(List<Stmt> statements) {
@@ -179,6 +242,27 @@ class Interpreter implements Expr.Visitor<Object>,
         locals.put(expr, depth);
     }
 
+    void inline(Stmt.Block block) {
+        inlineBlocks.add(block);
+    }
+
+    void inline(Stmt.Function function) {
+        framelessFunctions.add(function);
+    }
+
+    boolean needsFrame(Stmt.Function function) {
+        return !framelessFunctions.contains(function);
+    }
+
+    // AST 캐시에 리졸브 결과를 같이 저장할 때 쓴다.
+    Integer depth(Expr expr) {
+        return locals.get(expr);
+    }
+
+    boolean isInline(Stmt.Block block) {
+        return inlineBlocks.contains(block);
+    }
+
     void executeBlock(List<Stmt> statements,
                       Environment environment) {
         Environment previous = this.environment;
@@ -195,6 +279,14 @@ class Interpreter implements Expr.Visitor<Object>,
 
     @Override
     public Void visitBlockStmt(Stmt.Block stmt) {
+        if (inlineBlocks.contains(stmt)) {
+            // 바깥 Environment를 그대로 쓴다.
+            for (Stmt statement : stmt.statements) {
+                execute(statement);
+            }
+            return null;
+        }
+
         executeBlock(stmt.statements, new Environment(environment));
         return null;
     }
@@ -264,7 +356,6 @@ class Interpreter implements Expr.Visitor<Object>,
         } else {
             globals.assign(expr.name, value);
         }
-        environment.assign(expr.name, value);
         return value;
     }
 
@@ -372,7 +463,13 @@ class Interpreter implements Expr.Visitor<Object>,
                 arguments.size() + ".");
         }
 
-        return function.call(this, arguments);
+        try {
+            return function.call(this, arguments);
+        } catch (RuntimeError error) {
+            // 네이티브 함수는 토큰을 모르므로 호출 위치를 붙여서 다시 던진다.
+            if (error.token != null) throw error;
+            throw new RuntimeError(expr.paren, error.getMessage());
+        }
     }
 
     @Override
@@ -6,16 +6,21 @@ import java.io.InputStreamReader;
 import java.nio.charset.Charset;
 import java.nio.file.Files;
 import java.nio.file.Paths;
+import java.util.ArrayList;
 import java.util.List;
+import java.util.concurrent.ForkJoinPool;
+import java.util.concurrent.ForkJoinTask;
 
 public class Lox {
     private static final Interpreter interpreter = new Interpreter();
-    static boolean hadError = false;
-    static boolean hadRuntimeError = false;
+    static volatile boolean hadError = false;
+    static volatile boolean hadRuntimeError = false;
+    // 병렬 파싱 중의 에러는 파일별로 모았다가 파일 순서대로 출력한다.
+    private static final ThreadLocal<StringBuilder> errorBuffer =
+        new ThreadLocal<>();
     public static void main(String[] args) throws IOException {
         if (args.length > 1) {
-            System.out.println("Usage: jlox [script]");
-            System.exit(64);
+            runFiles(args);
         } else if (args.length == 1) {
             runFile(args[0]);
         } else {
@@ -24,14 +29,77 @@ public class Lox {
     }
 
     private static void runFile(String path) throws IOException {
-        byte[] bytes = Files.readAllBytes(Paths.get(path));
-        run(new String(bytes, Charset.defaultCharset()));
+        run(readFile(path), true);
+        LoxTask.reportUnjoined();
 
         // 종료 코드로 에러를 식별한다.
         if (hadError) System.exit(65);
         if (hadRuntimeError) System.exit(70);
     }
 
+    // 여러 파일을 한 프로그램으로 실행한다.
+    // 스캔과 파싱은 파일끼리 독립적이라 포크-조인 풀에서 병렬로 처리하고,
+    // 리졸브와 실행은 명령행에 준 순서대로 한다.
+    private static void runFiles(String[] paths) throws IOException {
+        String[] sources = new String[paths.length];
+        // AST 캐시에서 읽어 온 파일은 리졸브도 끝나 있다.
+        boolean[] cached = new boolean[paths.length];
+        StringBuilder[] errors = new StringBuilder[paths.length];
+        List<ForkJoinTask<List<Stmt>>> tasks = new ArrayList<>();
+        for (int i = 0; i < paths.length; i++) {
+            String path = paths[i];
+            String source = readFile(path);
+            int index = i;
+            sources[i] = source;
+            errors[i] = new StringBuilder();
+            tasks.add(ForkJoinPool.commonPool().submit(() -> {
+                List<Stmt> statements =
+                    AstCache.load(source, path, interpreter);
+                if (statements == null) {
+                    return parse(path, source, errors[index]);
+                }
+
+                cached[index] = true;
+                return statements;
+            }));
+        }
+
+        List<List<Stmt>> programs = new ArrayList<>();
+        for (int i = 0; i < tasks.size(); i++) {
+            programs.add(tasks.get(i).join());
+            System.err.print(errors[i]);
+        }
+
+        // 구문 에러가 하나라도 있으면 아무것도 실행하지 않는다.
+        if (hadError) System.exit(65);
+
+        for (int i = 0; i < programs.size(); i++) {
+            if (cached[i]) continue;
+            Resolver resolver = new Resolver(interpreter);
+            resolver.resolve(programs.get(i));
+        }
+
+        if (hadError) System.exit(65);
+
+        for (int i = 0; i < programs.size(); i++) {
+            if (cached[i]) continue;
+            AstCache.store(sources[i], programs.get(i), interpreter);
+        }
+
+        for (int i = 0; i < programs.size(); i++) {
+            interpreter.interpret(programs.get(i));
+            if (hadRuntimeError) break;
+        }
+        LoxTask.reportUnjoined();
+
+        if (hadRuntimeError) System.exit(70);
+    }
+
+    private static String readFile(String path) throws IOException {
+        byte[] bytes = Files.readAllBytes(Paths.get(path));
+        return new String(bytes, Charset.defaultCharset());
+    }
+
     private static void runPrompt() throws IOException {
         InputStreamReader input = new InputStreamReader(System.in);
         BufferedReader reader = new BufferedReader(input);
@@ -40,25 +108,49 @@ public class Lox {
             System.out.print("> ");
             String line = reader.readLine();
             if(line == null) break;
-            run(line);
+            run(line, false);
             hadError = false;
         }
+        LoxTask.reportUnjoined();
     }
 
-    private static void run(String source) {
-        Scanner scanner = new Scanner(source);
+    private static List<Stmt> parse(String path, String source) {
+        Scanner scanner = new Scanner(source, path);
         List<Token> tokens = scanner.scanTokens();
         Parser parser = new Parser(tokens);
-        List<Stmt> statements = parser.parse();
+        return parser.parse();
+    }
+
+    // 병렬 작업 안에서 파싱한다. 에러는 출력하지 않고 errors에 모은다.
+    private static List<Stmt> parse(String path, String source,
+                                    StringBuilder errors) {
+        errorBuffer.set(errors);
+        try {
+            return parse(path, source);
+        } finally {
+            errorBuffer.remove();
+        }
+    }
+
+    // cache가 참이면 리졸브까지 끝난 AST를 캐시에서 찾고, 없으면 만들어서 저장한다.
+    private static void run(String source, boolean cache) {
+        List<Stmt> statements = cache
+            ? AstCache.load(source, null, interpreter) : null;
 
-        // 구문 에러 발생 시 멈춘다
-        if (hadError) return;
-        
-        Resolver resolver = new Resolver(interpreter);
-        resolver.resolve(statements);
+        if (statements == null) {
+            statements = parse(null, source);
 
-        // 레졸루션 에러 발생 시 멈춘다.
-        if (hadError) return;
+            // 구문 에러 발생 시 멈춘다
+            if (hadError) return;
+
+            Resolver resolver = new Resolver(interpreter);
+            resolver.resolve(statements);
+
+            // 레졸루션 에러 발생 시 멈춘다.
+            if (hadError) return;
+
+            if (cache) AstCache.store(source, statements, interpreter);
+        }
 
         interpreter.interpret(statements);
         // System.out.println(new AstPrinter().print(expression));
@@ -70,27 +162,43 @@ public class Lox {
         */
     }
 
-    static void error(int line, String message) {
-        report(line, "", message);
+    static void error(String path, int line, String message) {
+        report(path, line, "", message);
     }
 
-    private static void report(int line, String where, String message) {
-        System.err.println(
-            "[Line " + line + "] Error" + where + ": " + message);
+    private static void report(String path, int line, String where,
+                               String message) {
+        String error =
+            "[" + location(path, line) + "] Error" + where + ": " + message;
+        StringBuilder buffer = errorBuffer.get();
+        if (buffer != null) {
+            buffer.append(error).append(System.lineSeparator());
+        } else {
+            System.err.println(error);
+        }
         hadError = true;
     }
 
+    // 파일이 여러 개면 "경로:줄", 아니면 "Line 줄"
+    private static String location(String path, int line) {
+        return path == null ? "Line " + line : path + ":" + line;
+    }
+
     static void error(Token token, String message) {
         if (token.type == TokenType.EOF) {
-            report(token.line, " at end", message);
+            report(token.path, token.line, " at end", message);
         } else {
-            report(token.line, " at '" + token.lexeme + "'", message);
+            report(token.path, token.line,
+                   " at '" + token.lexeme + "'", message);
         }
     }
 
+    // 에러를 낸 토큰의 파일로 보고한다. spawn된 클로저의 에러도
+    // 지금 실행 중인 파일이 아니라 클로저를 정의한 파일로 나온다.
     static void runtimeError(RuntimeError error) {
-        System.err.println(error.getMessage() + 
-           "\n[line " + error.token.line + "]");
+        String path = error.token.path;
+        System.err.println(error.getMessage() + "\n[" +
+           (path == null ? "line " : path + ":") + error.token.line + "]");
         hadRuntimeError = true;
     }
 }
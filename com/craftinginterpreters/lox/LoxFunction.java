@@ -23,6 +23,11 @@ class LoxFunction implements LoxCallable {
                                isInitializer);
     }
 
+    // 다른 스레드에서 호출하기 전에 클로저 환경을 공유 가능하게 만든다.
+    void share() {
+        closure.share();
+    }
+
     @Override
     public int arity() {
         return declaration.params.size();
@@ -37,7 +42,9 @@ class LoxFunction implements LoxCallable {
     public Object call(Interpreter interpreter,
                        List<Object> arguments) {
         // 호출할 때 새 환경을 만들어야한다.
-        Environment environment = new Environment(closure);
+        // 매개변수도 지역 선언도 없는 함수는 클로저 환경에서 바로 실행한다.
+        Environment environment = interpreter.needsFrame(declaration)
+            ? new Environment(closure) : closure;
         for (int i=0; i<declaration.params.size(); i++) {
             environment.define(declaration.params.get(i).lexeme,
             arguments.get(i)); 
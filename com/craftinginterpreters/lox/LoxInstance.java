@@ -11,7 +11,8 @@ class LoxInstance {
         this.klass = klass;
     }
 
-    Object get(Token name) {
+    // 인스턴스는 여러 스레드가 같이 쓸 수 있으므로 필드 접근을 동기화한다.
+    synchronized Object get(Token name) {
         if (fields.containsKey(name.lexeme)) {
             return fields.get(name.lexeme);
         }
@@ -23,7 +24,7 @@ class LoxInstance {
             "Undefined property '" + name.lexeme + "'.");
     }
 
-    void set(Token name, Object value) {
+    synchronized void set(Token name, Object value) {
         fields.put(name.lexeme, value);
     }
 
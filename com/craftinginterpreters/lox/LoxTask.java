@@ -0,0 +1,69 @@
+package com.craftinginterpreters.lox;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.LinkedHashSet;
+import java.util.List;
+import java.util.Set;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ForkJoinPool;
+import java.util.concurrent.ForkJoinTask;
+import java.util.concurrent.TimeUnit;
+
+// spawn()이 돌려주는 핸들. join()으로 결과를 받는다.
+class LoxTask {
+    // 작업 안에서 다른 작업을 join 해도 워커가 모자라지 않도록 포크-조인 풀을 쓴다.
+    private static final ForkJoinPool pool = new ForkJoinPool();
+    // 실패했는데 아직 아무도 join 하지 않은 작업. 실패한 순서대로 둔다.
+    private static final Set<LoxTask> unjoinedFailures =
+        Collections.synchronizedSet(new LinkedHashSet<>());
+
+    private final ForkJoinTask<Object> task;
+    // 작업 중 발생한 런타임 에러. join 하는 쪽에서 다시 던진다.
+    private volatile RuntimeError error = null;
+
+    LoxTask(Interpreter parent, LoxFunction function) {
+        function.share();
+        task = pool.submit((Callable<Object>)() -> {
+            // 스레드마다 자기 인터프리터 상태를 갖는다.
+            Interpreter interpreter = new Interpreter(parent);
+            try {
+                return function.call(interpreter, new ArrayList<>());
+            } catch (RuntimeError runtimeError) {
+                error = runtimeError;
+                unjoinedFailures.add(this);
+                return null;
+            }
+        });
+    }
+
+    Object join() {
+        Object value = task.join();
+        if (error != null) {
+            unjoinedFailures.remove(this);
+            throw error;
+        }
+        return value;
+    }
+
+    // 풀의 작업이 모두 끝나기를 기다린 뒤, join 되지 않은 채 실패한 작업의
+    // 에러를 보고한다. 인터프리터를 끝내기 전에 부른다.
+    static void reportUnjoined() {
+        pool.awaitQuiescence(Long.MAX_VALUE, TimeUnit.NANOSECONDS);
+
+        List<LoxTask> failures;
+        synchronized (unjoinedFailures) {
+            failures = new ArrayList<>(unjoinedFailures);
+            unjoinedFailures.clear();
+        }
+
+        for (LoxTask failure : failures) {
+            Lox.runtimeError(failure.error);
+        }
+    }
+
+    @Override
+    public String toString() {
+        return "<task>";
+    }
+}
@@ -1,5 +1,6 @@
 package com.craftinginterpreters.lox;
 
+import java.util.ArrayList;
 import java.util.HashMap;
 import java.util.List;
 import java.util.Map;
@@ -8,6 +9,10 @@ import java.util.Stack;
 class Resolver implements Expr.Visitor<Void>, Stmt.Visitor<Void> {
     private final Interpreter interpreter;
     private final Stack<Map<String, Boolean>> scopes = new Stack<>();
+    // 런타임에 자기 Environment 없이 바깥 Environment를 같이 쓰는 스코프인지
+    private final Stack<Boolean> inlined = new Stack<>();
+    // 현재 함수 프레임이 시작되는 스코프 인덱스. 이 아래로는 얹을 수 없다.
+    private int frameBase = 0;
     private FunctionType currentFunction = FunctionType.NONE;
     
     Resolver(Interpreter interpreter) {
@@ -47,8 +52,15 @@ class Resolver implements Expr.Visitor<Void>, Stmt.Visitor<Void> {
         Stmt.Function function, FunctionType type) {
         FunctionType enclosingFunction = currentFunction;
         currentFunction = type;
+        int enclosingFrameBase = frameBase;
+        frameBase = scopes.size();
 
-        beginScope();
+        // 매개변수도 지역 선언도 없으면 호출마다 프레임을 만들 필요가 없다.
+        boolean frameless = function.params.isEmpty() &&
+            declaredNames(function.body).isEmpty();
+        if (frameless) interpreter.inline(function);
+
+        beginScope(frameless);
         for (Token param : function.params) {
             declare(param);
             define(param);
@@ -56,15 +68,83 @@ class Resolver implements Expr.Visitor<Void>, Stmt.Visitor<Void> {
 
         resolve(function.body);
         endScope();
+        frameBase = enclosingFrameBase;
         currentFunction = enclosingFunction;
     }
 
     private void beginScope() {
+        beginScope(false);
+    }
+
+    private void beginScope(boolean inline) {
         scopes.push(new HashMap<String, Boolean>());
+        inlined.push(inline);
     }
 
     private void endScope() {
         scopes.pop();
+        inlined.pop();
+    }
+
+    // 블록이 바로 아래에 선언하는 이름들. 중첩 블록 안의 선언은 제외한다.
+    private static List<String> declaredNames(List<Stmt> statements) {
+        List<String> names = new ArrayList<>();
+        for (Stmt statement : statements) {
+            if (statement instanceof Stmt.Var) {
+                names.add(((Stmt.Var)statement).name.lexeme);
+            } else if (statement instanceof Stmt.Function) {
+                names.add(((Stmt.Function)statement).name.lexeme);
+            } else if (statement instanceof Stmt.Class) {
+                names.add(((Stmt.Class)statement).name.lexeme);
+            }
+        }
+        return names;
+    }
+
+    // 클로저는 선언된 시점의 Environment 체인을 붙잡는다.
+    // 함수나 클래스 선언이 들어있는 블록은 실행마다 새 Environment가 필요하다.
+    private static boolean declaresClosure(Stmt stmt) {
+        if (stmt instanceof Stmt.Function ||
+            stmt instanceof Stmt.Class) {
+            return true;
+        }
+
+        if (stmt instanceof Stmt.Block) {
+            for (Stmt statement : ((Stmt.Block)stmt).statements) {
+                if (declaresClosure(statement)) return true;
+            }
+        } else if (stmt instanceof Stmt.If) {
+            Stmt.If ifStmt = (Stmt.If)stmt;
+            return declaresClosure(ifStmt.thenBranch) ||
+                (ifStmt.elseBranch != null &&
+                 declaresClosure(ifStmt.elseBranch));
+        } else if (stmt instanceof Stmt.While) {
+            return declaresClosure(((Stmt.While)stmt).body);
+        }
+
+        return false;
+    }
+
+    // 블록을 바깥 Environment에 얹어도 되는지 판단한다.
+    // 선언이 없으면 항상 가능하다. 선언이 있으면 같은 함수 프레임 안에
+    // 실제 Environment가 있어야 하고, 그 사이 스코프의 이름을 가리지 않아야
+    // 하며, 클로저로 탈출하지 않아야 한다.
+    private boolean canInline(Stmt.Block block) {
+        List<String> names = declaredNames(block.statements);
+        if (names.isEmpty()) return true;
+        if (declaresClosure(block)) return false;
+
+        for (int i = scopes.size() - 1; i >= frameBase; i--) {
+            Map<String, Boolean> scope = scopes.get(i);
+            for (String name : names) {
+                if (scope.containsKey(name)) return false;
+            }
+
+            if (!inlined.get(i)) return true;
+        }
+
+        // 같은 프레임 안에 얹을 Environment가 없다 (전역 또는 프레임 없는 함수).
+        return false;
     }
 
     private void declare(Token name) {
@@ -85,18 +165,25 @@ class Resolver implements Expr.Visitor<Void>, Stmt.Visitor<Void> {
     }
 
     // 대입 표현식과 식별자, This, Super 표현식을 만났을 때만 실행
+    // 거리는 런타임에 실제로 만들어지는 Environment만 센다.
     private void resolveLocal(Expr expr, Token name) {
+        int distance = 0;
         for (int i = scopes.size() - 1; i >= 0; i--) {
             if (scopes.get(i).containsKey(name.lexeme)) {
-                interpreter.resolve(expr, scopes.size() - 1 - i);
+                interpreter.resolve(expr, distance);
                 return;
             }
+
+            if (!inlined.get(i)) distance++;
         }
     }
 
     @Override
     public Void visitBlockStmt(Stmt.Block stmt) {
-        beginScope();
+        boolean inline = canInline(stmt);
+        if (inline) interpreter.inline(stmt);
+
+        beginScope(inline);
         resolve(stmt.statements);
         endScope();
         return null;
@@ -9,6 +9,8 @@ import static com.craftinginterpreters.lox.TokenType.*;
 
 public class Scanner {
     private final String source;
+    // 토큰에 붙일 파일 경로. 없으면 null
+    private final String path;
     private final List<Token> tokens = new ArrayList<>();
     private int start = 0;
     private int current = 0;
@@ -36,7 +38,12 @@ public class Scanner {
     }
 
     Scanner(String source) {
+        this(source, null);
+    }
+
+    Scanner(String source, String path) {
         this.source = source;
+        this.path = path;
     }
 
     List<Token> scanTokens() {
@@ -46,7 +53,7 @@ public class Scanner {
             scanToken();
         }
 
-        tokens.add(new Token(EOF, "", null, line));
+        tokens.add(new Token(EOF, "", null, line, path));
         return tokens;
     }
 
@@ -64,7 +71,7 @@ public class Scanner {
 
     private void addToken(TokenType type, Object literal) {
         String text = source.substring(start, current);
-        tokens.add(new Token(type, text, literal, line));
+        tokens.add(new Token(type, text, literal, line, path));
     }
 
     private void scanToken() {
@@ -118,7 +125,7 @@ public class Scanner {
                 } else if (isAlpha(c)){
                     identifier();
                 } else {
-                Lox.error(line, "Unexpected character.");
+                Lox.error(path, line, "Unexpected character.");
                 }
                 break;
         }
@@ -165,7 +172,7 @@ public class Scanner {
         }
 
         if (isAtEnd()) {
-            Lox.error(line, "Unterminate string.");
+            Lox.error(path, line, "Unterminate string.");
             return;
         }
 
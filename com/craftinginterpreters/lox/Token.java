@@ -5,12 +5,20 @@ class Token {
     final String lexeme;
     final Object literal;
     final int line;
+    // 토큰이 나온 파일. 여러 파일을 실행할 때만 채운다.
+    final String path;
 
     Token(TokenType type, String lexeme, Object literal, int line) {
+        this(type, lexeme, literal, line, null);
+    }
+
+    Token(TokenType type, String lexeme, Object literal, int line,
+          String path) {
         this.type = type;
         this.lexeme = lexeme;
         this.literal = literal;
         this.line = line;
+        this.path = path;
     }
 
     public String toString() {